@@ -14,6 +14,7 @@ public class PBCharacterMovement : ModuleRules
 				"Core",
 				"CoreUObject",
 				"Engine",
+				"NavigationSystem",
 				"PhysicsCore"
 			}
 		);
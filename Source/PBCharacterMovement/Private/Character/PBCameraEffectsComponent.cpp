@@ -0,0 +1,83 @@
+// Copyright Project Borealis
+
+#include "Character/PBCameraEffectsComponent.h"
+
+#include "Camera/CameraTypes.h"
+
+#include "Character/PBPlayerCharacter.h"
+#include "Character/PBPlayerMovement.h"
+
+DECLARE_CYCLE_STAT(TEXT("PB Camera Effects"), STAT_PBCameraEffects, STATGROUP_Character);
+
+UPBCameraEffectsComponent::UPBCameraEffectsComponent()
+{
+	// Driven by the view, not by ticking
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UPBCameraEffectsComponent::ApplyToView(float DeltaTime, FMinimalViewInfo& InOutView)
+{
+	const APBPlayerCharacter* Character = Cast<APBPlayerCharacter>(GetOwner());
+	const UPBPlayerMovement* Movement = Character ? Character->GetMovementPtr() : nullptr;
+	if (!Movement)
+	{
+		return;
+	}
+
+	// The view can be calculated more than once a frame, the effects only move on once
+	if (LastFrame != GFrameCounter)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_PBCameraEffects);
+
+		LastFrame = GFrameCounter;
+		const FVector& Velocity = Movement->Velocity;
+
+		// Velocity along the view's right axis. The view has no roll of its own, so that is just the yaw's right.
+		float SinYaw, CosYaw;
+		FMath::SinCos(&SinYaw, &CosYaw, FMath::DegreesToRadians(InOutView.Rotation.Yaw));
+		const float Side = Velocity.Y * CosYaw - Velocity.X * SinYaw;
+		const float Speed2D = Velocity.Size2D();
+
+		// Roll towards the side we move to, up to RollAngle at RollSpeed
+		float Roll = 0.0f;
+		const float RollAngle = Movement->GetRollAngle();
+		const float RollSpeed = Movement->GetRollSpeed();
+		if (RollSpeed != 0.0f && RollAngle != 0.0f)
+		{
+			const float SideSpeed = FMath::Abs(Side);
+			Roll = FMath::Sign(Side) * (SideSpeed < RollSpeed ? SideSpeed * RollAngle / RollSpeed : RollAngle);
+		}
+
+		// Bob by distance travelled so it keeps pace with the footsteps, lowest on each footfall
+		const float TargetBobWeight = Movement->IsMovingOnGround() ? FMath::Min(Speed2D / FMath::Max(Movement->GetRunSpeed(), 1.0f), 1.0f) : 0.0f;
+		BobWeight = FMath::FInterpTo(BobWeight, TargetBobWeight, DeltaTime, 10.0f);
+		BobPhase = FMath::Fractional(BobPhase + Speed2D * DeltaTime / BobCycleLength);
+		const float Bob = BobAmplitude * BobWeight * (FMath::Abs(FMath::Sin(BobPhase * 2.0f * PI)) - 1.0f);
+
+		// Critically damped spring back from a landing, stepped semi-implicitly
+		const float SpringTime = FMath::Min(DeltaTime, 0.05f);
+		const float SpringFrequency = FMath::Sqrt(LandBounceStiffness);
+		float LandBounce = Effects.Z;
+		LandBounceVelocity += (-LandBounceStiffness * LandBounce - 2.0f * SpringFrequency * LandBounceVelocity) * SpringTime;
+		LandBounce += LandBounceVelocity * SpringTime;
+
+		Effects = FVector(Roll, Bob, LandBounce);
+	}
+
+	InOutView.Rotation.Roll += Effects.X;
+	InOutView.Location.Z += Effects.Y + Effects.Z;
+}
+
+void UPBCameraEffectsComponent::AddLandBounce(float FallSpeed)
+{
+	const APBPlayerCharacter* Character = Cast<APBPlayerCharacter>(GetOwner());
+	const float ExcessSpeed = Character ? FallSpeed - Character->GetMinLandBounceSpeed() : 0.0f;
+	if (ExcessSpeed <= 0.0f || LandBounceScale <= 0.0f)
+	{
+		return;
+	}
+
+	// A critically damped spring kicked with velocity V peaks at V / (frequency * e), so kick it to peak at the drop
+	const float Drop = FMath::Min(ExcessSpeed * LandBounceScale, MaxLandBounce);
+	LandBounceVelocity -= Drop * FMath::Sqrt(LandBounceStiffness) * 2.71828182845904523536f;
+}
@@ -0,0 +1,69 @@
+// Copyright Project Borealis
+
+#include "Character/PBCapsuleHistory.h"
+
+DECLARE_CYCLE_STAT(TEXT("PB Capsule History Rewind"), STAT_PBCapsuleHistoryRewind, STATGROUP_Character);
+
+void FPBCapsuleHistory::Record(float Time, const FVector& Location, const FQuat& Rotation, float HalfHeight)
+{
+	if (NumSamples == 0 || Time > Samples[Head].Time)
+	{
+		Head = (Head + 1) % MaxSamples;
+		NumSamples = FMath::Min(NumSamples + 1, MaxSamples);
+	}
+
+	FPBCapsuleHistorySample& Sample = Samples[Head];
+	Sample.Time = Time;
+	Sample.Location = Location;
+	Sample.Rotation = Rotation;
+	Sample.HalfHeight = HalfHeight;
+}
+
+bool FPBCapsuleHistory::Rewind(float Time, FPBCapsuleHistorySample& OutSample) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_PBCapsuleHistoryRewind);
+
+	if (NumSamples == 0)
+	{
+		return false;
+	}
+
+	const FPBCapsuleHistorySample& Newest = GetSample(0);
+	if (Time >= Newest.Time)
+	{
+		OutSample = Newest;
+		return true;
+	}
+
+	const FPBCapsuleHistorySample& Oldest = GetSample(NumSamples - 1);
+	if (Time <= Oldest.Time)
+	{
+		OutSample = Oldest;
+		return true;
+	}
+
+	// Binary search by age for the newest sample at or before the time
+	int32 Low = 0;
+	int32 High = NumSamples - 1;
+	while (High - Low > 1)
+	{
+		const int32 Mid = (Low + High) / 2;
+		if (GetSample(Mid).Time > Time)
+		{
+			Low = Mid;
+		}
+		else
+		{
+			High = Mid;
+		}
+	}
+
+	const FPBCapsuleHistorySample& Before = GetSample(High);
+	const FPBCapsuleHistorySample& After = GetSample(Low);
+	const float Alpha = (Time - Before.Time) / FMath::Max(After.Time - Before.Time, KINDA_SMALL_NUMBER);
+	OutSample.Time = Time;
+	OutSample.Location = FMath::Lerp(Before.Location, After.Location, Alpha);
+	OutSample.Rotation = FQuat::Slerp(Before.Rotation, After.Rotation, Alpha);
+	OutSample.HalfHeight = FMath::Lerp(Before.HalfHeight, After.HalfHeight, Alpha);
+	return true;
+}
@@ -0,0 +1,217 @@
+// Copyright Project Borealis
+
+#include "Character/PBCorrectionTelemetrySubsystem.h"
+
+#include "Engine/NetConnection.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogPBCorrections, Log, All);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("PB Corrections"), STAT_PBCorrections, STATGROUP_Character);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("PB Corrections: Movement Mode"), STAT_PBCorrectionsMovementMode, STATGROUP_Character);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("PB Corrections: Crouch Transition"), STAT_PBCorrectionsCrouchTransition, STATGROUP_Character);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("PB Corrections: Sprint Change"), STAT_PBCorrectionsSprintChange, STATGROUP_Character);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("PB Corrections: Friction Change"), STAT_PBCorrectionsFrictionChange, STATGROUP_Character);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("PB Corrections: Catch Air"), STAT_PBCorrectionsCatchAir, STATGROUP_Character);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("PB Corrections: Other"), STAT_PBCorrectionsOther, STATGROUP_Character);
+
+static FAutoConsoleCommandWithWorld DumpCorrectionsCommand(TEXT("pb.DumpCorrections"), TEXT("Write PB movement correction telemetry to a CSV file in the profiling directory.\n"), FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World) {
+	if (const UPBCorrectionTelemetrySubsystem* Telemetry = UWorld::GetSubsystem<UPBCorrectionTelemetrySubsystem>(World))
+	{
+		const FString Filename = Telemetry->DumpCsv();
+		UE_LOG(LogPBCorrections, Log, TEXT("Wrote correction telemetry to %s"), *Filename);
+	}
+}));
+
+const TCHAR* UPBCorrectionTelemetrySubsystem::GetCauseName(int32 CauseIndex)
+{
+	static const TCHAR* CauseNames[NumCauses] = {TEXT("MovementMode"), TEXT("CrouchTransition"), TEXT("SprintChange"), TEXT("FrictionChange"), TEXT("CatchAir"), TEXT("Other")};
+	return CauseNames[CauseIndex];
+}
+
+void UPBCorrectionTelemetrySubsystem::FConnectionCorrections::Add(EPBCorrectionCause Causes)
+{
+	Total++;
+	if (Causes == EPBCorrectionCause::None)
+	{
+		ByCause[NumCauses - 1]++;
+	}
+	for (int32 CauseIndex = 0; CauseIndex < NumCauses - 1; CauseIndex++)
+	{
+		if (EnumHasAnyFlags(Causes, (EPBCorrectionCause)(1 << CauseIndex)))
+		{
+			ByCause[CauseIndex]++;
+		}
+	}
+}
+
+void UPBCorrectionTelemetrySubsystem::FConnectionCorrections::Add(const FConnectionCorrections& Other)
+{
+	Total += Other.Total;
+	for (int32 CauseIndex = 0; CauseIndex < NumCauses; CauseIndex++)
+	{
+		ByCause[CauseIndex] += Other.ByCause[CauseIndex];
+	}
+}
+
+void UPBCorrectionTelemetrySubsystem::Deinitialize()
+{
+	Connections.Reset();
+	LocalCorrections = FConnectionCorrections();
+	DisconnectedCorrections = FConnectionCorrections();
+	Recent.Reset();
+
+	Super::Deinitialize();
+}
+
+int32 UPBCorrectionTelemetrySubsystem::GetMagnitudeBucket(float Magnitude)
+{
+	int32 Bucket = 0;
+	float BucketMax = 1.0f;
+	while (Magnitude >= BucketMax && Bucket < NumMagnitudeBuckets - 1)
+	{
+		BucketMax *= 2.0f;
+		Bucket++;
+	}
+	return Bucket;
+}
+
+void UPBCorrectionTelemetrySubsystem::AddToHistogram(const FRecentCorrection& Correction, int32 Count)
+{
+	if (Correction.Causes == EPBCorrectionCause::None)
+	{
+		Histogram[NumCauses - 1][Correction.Bucket] += Count;
+		return;
+	}
+	for (int32 CauseIndex = 0; CauseIndex < NumCauses - 1; CauseIndex++)
+	{
+		if (EnumHasAnyFlags(Correction.Causes, (EPBCorrectionCause)(1 << CauseIndex)))
+		{
+			Histogram[CauseIndex][Correction.Bucket] += Count;
+		}
+	}
+}
+
+void UPBCorrectionTelemetrySubsystem::RecordCorrection(const UNetConnection* Connection, EPBCorrectionCause Causes, float Magnitude)
+{
+	INC_DWORD_STAT(STAT_PBCorrections);
+	if (EnumHasAnyFlags(Causes, EPBCorrectionCause::MovementMode))
+	{
+		INC_DWORD_STAT(STAT_PBCorrectionsMovementMode);
+	}
+	if (EnumHasAnyFlags(Causes, EPBCorrectionCause::CrouchTransition))
+	{
+		INC_DWORD_STAT(STAT_PBCorrectionsCrouchTransition);
+	}
+	if (EnumHasAnyFlags(Causes, EPBCorrectionCause::SprintChange))
+	{
+		INC_DWORD_STAT(STAT_PBCorrectionsSprintChange);
+	}
+	if (EnumHasAnyFlags(Causes, EPBCorrectionCause::FrictionChange))
+	{
+		INC_DWORD_STAT(STAT_PBCorrectionsFrictionChange);
+	}
+	if (EnumHasAnyFlags(Causes, EPBCorrectionCause::CatchAir))
+	{
+		INC_DWORD_STAT(STAT_PBCorrectionsCatchAir);
+	}
+	if (Causes == EPBCorrectionCause::None)
+	{
+		INC_DWORD_STAT(STAT_PBCorrectionsOther);
+	}
+
+	if (!Connection)
+	{
+		LocalCorrections.Add(Causes);
+	}
+	else
+	{
+		FConnectionCorrections* Counts = Connections.Find(Connection);
+		if (!Counts)
+		{
+			// Only a new connection can grow the map, so that's when to drop the closed ones
+			PruneConnections();
+			Counts = &Connections.Add(Connection);
+			Counts->Name = Connection->LowLevelGetRemoteAddress(true);
+		}
+		Counts->Add(Causes);
+	}
+
+	const FRecentCorrection Correction = {Causes, GetMagnitudeBucket(Magnitude)};
+	if (Recent.Num() < RollingWindow)
+	{
+		Recent.Add(Correction);
+	}
+	else
+	{
+		// Oldest correction leaves the window
+		AddToHistogram(Recent[RecentHead], -1);
+		Recent[RecentHead] = Correction;
+		RecentHead = (RecentHead + 1) % RollingWindow;
+	}
+	AddToHistogram(Correction, 1);
+}
+
+void UPBCorrectionTelemetrySubsystem::PruneConnections()
+{
+	for (auto It = Connections.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid())
+		{
+			DisconnectedCorrections.Add(It.Value());
+			It.RemoveCurrent();
+		}
+	}
+}
+
+FString UPBCorrectionTelemetrySubsystem::DumpCsv() const
+{
+	FString Csv = TEXT("Connection,Total");
+	for (int32 CauseIndex = 0; CauseIndex < NumCauses; CauseIndex++)
+	{
+		Csv += FString::Printf(TEXT(",%s"), GetCauseName(CauseIndex));
+	}
+	Csv += LINE_TERMINATOR;
+	auto AddRow = [&Csv](const TCHAR* Name, const FConnectionCorrections& Counts)
+	{
+		Csv += FString::Printf(TEXT("%s,%d"), Name, Counts.Total);
+		for (int32 CauseIndex = 0; CauseIndex < NumCauses; CauseIndex++)
+		{
+			Csv += FString::Printf(TEXT(",%d"), Counts.ByCause[CauseIndex]);
+		}
+		Csv += LINE_TERMINATOR;
+	};
+	AddRow(TEXT("Local"), LocalCorrections);
+	AddRow(TEXT("Disconnected"), DisconnectedCorrections);
+	for (const TPair<TWeakObjectPtr<const UNetConnection>, FConnectionCorrections>& Connection : Connections)
+	{
+		// Closed but not yet pruned connections are still listed by their address
+		AddRow(*Connection.Value.Name, Connection.Value);
+	}
+
+	// Histogram of the last RollingWindow corrections, one row per size bucket
+	Csv += LINE_TERMINATOR;
+	Csv += TEXT("MagnitudeBelow");
+	for (int32 CauseIndex = 0; CauseIndex < NumCauses; CauseIndex++)
+	{
+		Csv += FString::Printf(TEXT(",%s"), GetCauseName(CauseIndex));
+	}
+	Csv += LINE_TERMINATOR;
+	for (int32 Bucket = 0; Bucket < NumMagnitudeBuckets; Bucket++)
+	{
+		Csv += Bucket < NumMagnitudeBuckets - 1 ? FString::Printf(TEXT("%d"), 1 << Bucket) : FString(TEXT("Inf"));
+		for (int32 CauseIndex = 0; CauseIndex < NumCauses; CauseIndex++)
+		{
+			Csv += FString::Printf(TEXT(",%d"), Histogram[CauseIndex][Bucket]);
+		}
+		Csv += LINE_TERMINATOR;
+	}
+
+	const FString Filename = FPaths::ProfilingDir() / FString::Printf(TEXT("PBCorrections-%s.csv"), *FDateTime::Now().ToString());
+	FFileHelper::SaveStringToFile(Csv, *Filename);
+	return Filename;
+}
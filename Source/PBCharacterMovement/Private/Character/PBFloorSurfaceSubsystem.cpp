@@ -0,0 +1,146 @@
+// Copyright Project Borealis
+
+#include "Character/PBFloorSurfaceSubsystem.h"
+
+#include "Components/StaticMeshComponent.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "Engine/Engine.h"
+#include "Engine/StaticMesh.h"
+#include "Materials/MaterialInterface.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Floor Surface Cache Hits"), STAT_PBFloorSurfaceCacheHits, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Floor Surface Cache Resolves"), STAT_PBFloorSurfaceCacheResolves, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Floor Surface Traced"), STAT_PBFloorSurfaceTraced, STATGROUP_Character);
+
+void UPBFloorSurfaceSubsystem::Deinitialize()
+{
+	Entries.Reset();
+
+	Super::Deinitialize();
+}
+
+float UPBFloorSurfaceSubsystem::GetFriction(const UPhysicalMaterial* PhysMaterial)
+{
+	return PhysMaterial ? FMath::Min(1.0f, PhysMaterial->Friction * 1.25f) : 1.0f;
+}
+
+bool UPBFloorSurfaceSubsystem::FindSurface(const UPrimitiveComponent* Component, FPBFloorSurface& OutSurface)
+{
+	// Only static meshes map every face to a material we can look up without a trace
+	if (!Component || !Component->IsA<UStaticMeshComponent>())
+	{
+		INC_DWORD_STAT(STAT_PBFloorSurfaceTraced);
+		return false;
+	}
+
+	FEntry* Entry = Entries.Find(Component);
+	if (!Entry || !IsEntryValid(Component, *Entry))
+	{
+		if (!Entry)
+		{
+			if (Entries.Num() >= MaxEntries)
+			{
+				Entries.Reset();
+			}
+			Entry = &Entries.Add(Component);
+		}
+		Resolve(Component, *Entry);
+		INC_DWORD_STAT(STAT_PBFloorSurfaceCacheResolves);
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_PBFloorSurfaceCacheHits);
+	}
+
+	if (!Entry->bUniform)
+	{
+		INC_DWORD_STAT(STAT_PBFloorSurfaceTraced);
+		return false;
+	}
+
+	OutSurface = Entry->Surface;
+	return true;
+}
+
+void UPBFloorSurfaceSubsystem::Resolve(const UPrimitiveComponent* Component, FEntry& Entry)
+{
+	const UStaticMeshComponent* MeshComponent = CastChecked<UStaticMeshComponent>(Component);
+
+	Entry.Component = Component;
+	Entry.StaticMesh = MeshComponent->GetStaticMesh();
+	Entry.PhysMaterialOverride = Component->BodyInstance.bOverridePhysMat ? Component->BodyInstance.GetSimplePhysicalMaterial() : nullptr;
+	Entry.SimplePhysMaterial = Component->BodyInstance.GetSimplePhysicalMaterial();
+	Entry.Materials.Reset();
+	for (int32 Index = 0; Index < Component->GetNumMaterials(); Index++)
+	{
+		Entry.Materials.Add(Component->GetMaterial(Index));
+	}
+
+	// An override applies to every face, simple and complex
+	const UPhysicalMaterial* PhysMaterial = Entry.PhysMaterialOverride;
+	bool bUniform = PhysMaterial != nullptr;
+	if (!PhysMaterial)
+	{
+		const UBodySetup* BodySetup = Component->BodyInstance.GetBodySetup();
+		const ECollisionTraceFlag TraceFlag = BodySetup ? BodySetup->GetCollisionTraceFlag() : CTF_UseDefault;
+
+		// Complex traces of simple as complex meshes hit the simple shapes, with the body setup's material
+		const bool bMayTraceSimple = TraceFlag != CTF_UseComplexAsSimple;
+		const bool bMayTraceComplex = TraceFlag != CTF_UseSimpleAsComplex;
+
+		bUniform = BodySetup != nullptr && (!bMayTraceComplex || Entry.Materials.Num() > 0);
+		if (bUniform && bMayTraceComplex)
+		{
+			for (const UMaterialInterface* Material : Entry.Materials)
+			{
+				// Materials without a physical material use the default one, as the trace would
+				const UPhysicalMaterial* MaterialPhysMaterial = Material ? Material->GetPhysicalMaterial() : GEngine->DefaultPhysMaterial;
+				if (PhysMaterial && MaterialPhysMaterial != PhysMaterial)
+				{
+					bUniform = false;
+					break;
+				}
+				PhysMaterial = MaterialPhysMaterial;
+			}
+		}
+		// By default the trace is complex only if the mesh has complex collision data, so both have to agree
+		if (bUniform && bMayTraceSimple)
+		{
+			if (PhysMaterial && PhysMaterial != Entry.SimplePhysMaterial)
+			{
+				bUniform = false;
+			}
+			PhysMaterial = Entry.SimplePhysMaterial;
+		}
+	}
+
+	Entry.bUniform = bUniform;
+	Entry.Surface.Friction = GetFriction(PhysMaterial);
+	Entry.Surface.SurfaceType = PhysMaterial ? PhysMaterial->SurfaceType : TEnumAsByte<EPhysicalSurface>(SurfaceType_Default);
+}
+
+bool UPBFloorSurfaceSubsystem::IsEntryValid(const UPrimitiveComponent* Component, const FEntry& Entry)
+{
+	// The address may have been reused by a new component
+	if (Entry.Component.Get() != Component)
+	{
+		return false;
+	}
+
+	const UStaticMeshComponent* MeshComponent = CastChecked<UStaticMeshComponent>(Component);
+	const UPhysicalMaterial* PhysMaterialOverride = Component->BodyInstance.bOverridePhysMat ? Component->BodyInstance.GetSimplePhysicalMaterial() : nullptr;
+	if (MeshComponent->GetStaticMesh() != Entry.StaticMesh || PhysMaterialOverride != Entry.PhysMaterialOverride ||
+		Component->BodyInstance.GetSimplePhysicalMaterial() != Entry.SimplePhysMaterial || Component->GetNumMaterials() != Entry.Materials.Num())
+	{
+		return false;
+	}
+	for (int32 Index = 0; Index < Entry.Materials.Num(); Index++)
+	{
+		if (Component->GetMaterial(Index) != Entry.Materials[Index])
+		{
+			return false;
+		}
+	}
+	return true;
+}
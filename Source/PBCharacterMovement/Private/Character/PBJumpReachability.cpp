@@ -0,0 +1,141 @@
+// Copyright Project Borealis
+
+#include "Character/PBJumpReachability.h"
+
+#include "HAL/IConsoleManager.h"
+
+#include "Character/PBPlayerMovement.h"
+
+DECLARE_CYCLE_STAT(TEXT("PB Generate Jump Reachability"), STAT_PBGenerateJumpReachability, STATGROUP_Character);
+
+static int32 GetConsoleInt(const IConsoleVariable* Variable)
+{
+	return Variable ? Variable->GetInt() : 0;
+}
+
+uint32 FPBJumpReachability::GetTuningHash(const UPBPlayerMovement& Movement)
+{
+	// Looked up on first use, long after the character registers them
+	static const IConsoleVariable* const JumpBoostVariable = IConsoleManager::Get().FindConsoleVariable(TEXT("move.JumpBoost"));
+	static const IConsoleVariable* const BunnyhoppingVariable = IConsoleManager::Get().FindConsoleVariable(TEXT("move.Bunnyhopping"));
+
+	uint32 Hash = GetTypeHash(Movement.JumpZVelocity);
+	Hash = HashCombine(Hash, GetTypeHash(Movement.GetGravityZ()));
+	Hash = HashCombine(Hash, GetTypeHash(Movement.GetRunSpeed()));
+	Hash = HashCombine(Hash, GetTypeHash(Movement.GetSprintSpeed()));
+	Hash = HashCombine(Hash, GetTypeHash(Movement.GetAirSpeedCap()));
+	Hash = HashCombine(Hash, GetTypeHash(Movement.GetAirAccelerationMultiplier()));
+	Hash = HashCombine(Hash, GetTypeHash(Movement.GetMaxAcceleration()));
+	Hash = HashCombine(Hash, GetTypeHash(Movement.GetAxisSpeedLimit()));
+	Hash = HashCombine(Hash, GetTypeHash(Movement.GetCrouchGeometry().FullCrouchDiff));
+	Hash = HashCombine(Hash, GetTypeHash(GetConsoleInt(JumpBoostVariable)));
+	Hash = HashCombine(Hash, GetTypeHash(GetConsoleInt(BunnyhoppingVariable)));
+	return Hash;
+}
+
+TSharedRef<const FPBJumpReachability> FPBJumpReachability::Generate(const UPBPlayerMovement& Movement)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PBGenerateJumpReachability);
+
+	TSharedRef<FPBJumpReachability> Reachability = MakeShared<FPBJumpReachability>();
+	Reachability->TuningHash = GetTuningHash(Movement);
+
+	// Crouching in the air pulls the feet up by the full height difference
+	const float CrouchBonus = 2.0f * Movement.GetCrouchGeometry().FullCrouchDiff;
+
+	FPBTrajectoryParams Params;
+	Params.TimeStep = 1.0f / 60.0f;
+	const int32 MaxTicks = 600;
+
+	TArray<FPBTrajectoryState> States;
+	for (int32 StateIndex = 0; StateIndex < (int32)EPBJumpReachState::Count; StateIndex++)
+	{
+		const EPBJumpReachState State = (EPBJumpReachState)StateIndex;
+		const bool bSprint = State == EPBJumpReachState::Sprint;
+		Params.MaxSpeed = bSprint ? Movement.GetSprintSpeed() : Movement.GetRunSpeed();
+		Params.bReducedJumpBoost = bSprint;
+
+		for (int32 BoostIndex = 0; BoostIndex < 2; BoostIndex++)
+		{
+			Params.bApplyJumpBoost = BoostIndex == 1;
+
+			// Take off at full speed, holding forward the whole way
+			FPBTrajectoryState Start;
+			Start.Velocity = FVector(Params.MaxSpeed, 0.0f, 0.0f);
+			Start.bOnGround = true;
+			FPBTrajectoryInput Inputs[2];
+			Inputs[0].Acceleration = FVector(Movement.GetMaxAcceleration(), 0.0f, 0.0f);
+			Inputs[0].bJump = true;
+			Inputs[1].Acceleration = Inputs[0].Acceleration;
+			Movement.PredictTrajectory(Start, Inputs, MaxTicks, Params, States);
+
+			TArray<float>& Envelope = Reachability->Envelopes[StateIndex][BoostIndex];
+			FVector PrevLocation = Start.Location;
+			for (const FPBTrajectoryState& Predicted : States)
+			{
+				// Fill every bucket the segment since the previous tick crosses
+				const int32 FirstBucket = FMath::FloorToInt(PrevLocation.X / BucketSize);
+				const int32 LastBucket = FMath::FloorToInt(Predicted.Location.X / BucketSize);
+				for (int32 Bucket = Envelope.Num(); Bucket <= LastBucket; Bucket++)
+				{
+					Envelope.Add(-MaxDropHeight);
+				}
+				for (int32 Bucket = FirstBucket; Bucket <= LastBucket; Bucket++)
+				{
+					const float SegmentLength = Predicted.Location.X - PrevLocation.X;
+					const float Alpha = SegmentLength > KINDA_SMALL_NUMBER ? FMath::Clamp((Bucket * BucketSize - PrevLocation.X) / SegmentLength, 0.0f, 1.0f) : 1.0f;
+					const float Height = FMath::Lerp(PrevLocation.Z, Predicted.Location.Z, Alpha);
+					Envelope[Bucket] = FMath::Max(Envelope[Bucket], Height);
+				}
+				PrevLocation = Predicted.Location;
+				if (Predicted.Location.Z < -MaxDropHeight)
+				{
+					break;
+				}
+			}
+
+			// A slower takeoff can put the apex anywhere nearer, so nothing closer is harder to reach
+			for (int32 Bucket = Envelope.Num() - 2; Bucket >= 0; Bucket--)
+			{
+				Envelope[Bucket] = FMath::Max(Envelope[Bucket], Envelope[Bucket + 1]);
+			}
+			if (State == EPBJumpReachState::CrouchJump)
+			{
+				for (float& Height : Envelope)
+				{
+					Height += CrouchBonus;
+				}
+			}
+		}
+	}
+
+	return Reachability;
+}
+
+float FPBJumpReachability::GetMaxHeight(EPBJumpReachState State, bool bJumpBoost, float HorizontalDistance) const
+{
+	const TArray<float>& Envelope = GetEnvelope(State, bJumpBoost);
+	const int32 Bucket = FMath::Max(0, FMath::FloorToInt(HorizontalDistance / BucketSize));
+	return Envelope.IsValidIndex(Bucket) ? Envelope[Bucket] : -MaxDropHeight;
+}
+
+float FPBJumpReachability::GetMaxDistance(EPBJumpReachState State, bool bJumpBoost, float Height) const
+{
+	// The envelope never increases, so find the last bucket still high enough
+	const TArray<float>& Envelope = GetEnvelope(State, bJumpBoost);
+	int32 Low = 0;
+	int32 High = Envelope.Num();
+	while (Low < High)
+	{
+		const int32 Mid = (Low + High) / 2;
+		if (Envelope[Mid] >= Height)
+		{
+			Low = Mid + 1;
+		}
+		else
+		{
+			High = Mid;
+		}
+	}
+	return Low * BucketSize;
+}
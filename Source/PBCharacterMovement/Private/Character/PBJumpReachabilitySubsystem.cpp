@@ -0,0 +1,37 @@
+// Copyright Project Borealis
+
+#include "Character/PBJumpReachabilitySubsystem.h"
+
+#include "Character/PBJumpReachability.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("PB Jump Reachability Tunings"), STAT_PBJumpReachabilityTunings, STATGROUP_Character);
+
+void UPBJumpReachabilitySubsystem::Deinitialize()
+{
+	DEC_DWORD_STAT_BY(STAT_PBJumpReachabilityTunings, ReachabilityByTuning.Num());
+	ReachabilityByTuning.Reset();
+
+	Super::Deinitialize();
+}
+
+TSharedRef<const FPBJumpReachability> UPBJumpReachabilitySubsystem::FindOrGenerate(const UPBPlayerMovement& Movement, uint32 TuningHash)
+{
+	check(IsInGameThread());
+
+	if (const TSharedRef<const FPBJumpReachability>* Found = ReachabilityByTuning.Find(TuningHash))
+	{
+		return *Found;
+	}
+
+	if (ReachabilityByTuning.Num() >= MaxTunings)
+	{
+		// Pawns keep their own reference to the tables they use
+		DEC_DWORD_STAT_BY(STAT_PBJumpReachabilityTunings, ReachabilityByTuning.Num());
+		ReachabilityByTuning.Reset();
+	}
+
+	const TSharedRef<const FPBJumpReachability> Generated = FPBJumpReachability::Generate(Movement);
+	ReachabilityByTuning.Add(TuningHash, Generated);
+	INC_DWORD_STAT(STAT_PBJumpReachabilityTunings);
+	return Generated;
+}
@@ -0,0 +1,106 @@
+// Copyright Project Borealis
+
+#include "Character/PBLadderSubsystem.h"
+
+#include "Character/PBLadderVolume.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Ladder Lookups"), STAT_PBLadderLookups, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Ladder Candidates Tested"), STAT_PBLadderCandidatesTested, STATGROUP_Character);
+
+void UPBLadderSubsystem::Deinitialize()
+{
+	Cells.Reset();
+	NumLadders = 0;
+
+	Super::Deinitialize();
+}
+
+void UPBLadderSubsystem::RegisterLadder(APBLadderVolume* Ladder)
+{
+	if (!Ladder)
+	{
+		return;
+	}
+
+	const FBox Bounds = Ladder->GetLadderBounds();
+	const FIntVector MinCell = GetCell(Bounds.Min);
+	const FIntVector MaxCell = GetCell(Bounds.Max);
+	bool bAdded = false;
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			for (int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++)
+			{
+				FLadderCell& Cell = Cells.FindOrAdd(FIntVector(X, Y, Z));
+				if (!Cell.Contains(Ladder))
+				{
+					Cell.Add(Ladder);
+					bAdded = true;
+				}
+			}
+		}
+	}
+	if (bAdded)
+	{
+		NumLadders++;
+	}
+}
+
+void UPBLadderSubsystem::UnregisterLadder(APBLadderVolume* Ladder)
+{
+	bool bRemoved = false;
+	for (auto It = Cells.CreateIterator(); It; ++It)
+	{
+		if (It.Value().RemoveSingleSwap(Ladder) > 0)
+		{
+			bRemoved = true;
+			if (It.Value().Num() == 0)
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+	if (bRemoved)
+	{
+		NumLadders--;
+	}
+}
+
+APBLadderVolume* UPBLadderSubsystem::FindLadder(const FVector& Location, float Radius, float HalfHeight) const
+{
+	INC_DWORD_STAT(STAT_PBLadderLookups);
+
+	if (NumLadders == 0)
+	{
+		return nullptr;
+	}
+
+	const FVector Extent(Radius, Radius, HalfHeight);
+	const FIntVector MinCell = GetCell(Location - Extent);
+	const FIntVector MaxCell = GetCell(Location + Extent);
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			for (int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++)
+			{
+				const FLadderCell* Cell = Cells.Find(FIntVector(X, Y, Z));
+				if (!Cell)
+				{
+					continue;
+				}
+				for (APBLadderVolume* Ladder : *Cell)
+				{
+					INC_DWORD_STAT(STAT_PBLadderCandidatesTested);
+					if (Ladder->IsCapsuleOnLadder(Location, Radius, HalfHeight))
+					{
+						return Ladder;
+					}
+				}
+			}
+		}
+	}
+
+	return nullptr;
+}
@@ -0,0 +1,58 @@
+// Copyright Project Borealis
+
+#include "Character/PBLadderVolume.h"
+
+#include "Components/BoxComponent.h"
+#include "Engine/World.h"
+
+#include "Character/PBLadderSubsystem.h"
+
+APBLadderVolume::APBLadderVolume(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
+{
+	LadderBox = CreateDefaultSubobject<UBoxComponent>(TEXT("LadderBox"));
+	LadderBox->InitBoxExtent(FVector(8.0f, 32.0f, 128.0f));
+	// Pawns find ladders through the ladder subsystem, so the box never needs to collide or overlap
+	LadderBox->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	LadderBox->SetGenerateOverlapEvents(false);
+	LadderBox->SetCanEverAffectNavigation(false);
+	RootComponent = LadderBox;
+
+	PrimaryActorTick.bCanEverTick = false;
+}
+
+void APBLadderVolume::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (UPBLadderSubsystem* LadderSubsystem = UWorld::GetSubsystem<UPBLadderSubsystem>(GetWorld()))
+	{
+		LadderSubsystem->RegisterLadder(this);
+	}
+}
+
+void APBLadderVolume::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UPBLadderSubsystem* LadderSubsystem = UWorld::GetSubsystem<UPBLadderSubsystem>(GetWorld()))
+	{
+		LadderSubsystem->UnregisterLadder(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+FBox APBLadderVolume::GetLadderBounds() const
+{
+	return LadderBox->Bounds.GetBox();
+}
+
+bool APBLadderVolume::IsCapsuleOnLadder(const FVector& Location, float Radius, float HalfHeight) const
+{
+	// Test in the box's space, treating the capsule as its bounding box
+	const FTransform& BoxTransform = LadderBox->GetComponentTransform();
+	const FVector LocalLocation = BoxTransform.InverseTransformPositionNoScale(Location);
+	const FVector Extent = LadderBox->GetScaledBoxExtent();
+	const FVector LocalUp = BoxTransform.InverseTransformVectorNoScale(FVector::UpVector);
+	// Capsule extent along each of the box's axes
+	const FVector CapsuleExtent = FVector(Radius) + LocalUp.GetAbs() * (HalfHeight - Radius);
+	return FMath::Abs(LocalLocation.X) <= Extent.X + CapsuleExtent.X && FMath::Abs(LocalLocation.Y) <= Extent.Y + CapsuleExtent.Y && FMath::Abs(LocalLocation.Z) <= Extent.Z + CapsuleExtent.Z;
+}
@@ -0,0 +1,369 @@
+// Copyright Project Borealis
+
+#include "Character/PBMovementTickSubsystem.h"
+
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+#include "Character/PBPlayerMovement.h"
+
+DECLARE_CYCLE_STAT(TEXT("PB Aggregated Movement Tick"), STAT_PBAggregatedMovementTick, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Aggregated Movement Pawns"), STAT_PBAggregatedMovementPawns, STATGROUP_Character);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("PB Aggregated Tick Overhead Per Pawn (us)"), STAT_PBAggregatedTickOverheadPerPawn, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Pushes Queued"), STAT_PBPushesQueued, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Pushes Merged"), STAT_PBPushesMerged, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Pushes Applied"), STAT_PBPushesApplied, STATGROUP_Character);
+
+void FPBMovementAggregateTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target)
+	{
+		Target->TickMovements(DeltaTime, TickType);
+	}
+}
+
+FString FPBMovementAggregateTickFunction::DiagnosticMessage()
+{
+	return TEXT("FPBMovementAggregateTickFunction");
+}
+
+void UPBMovementTickSubsystem::Deinitialize()
+{
+	if (AggregateTick.IsTickFunctionRegistered())
+	{
+		AggregateTick.UnRegisterTickFunction();
+	}
+	AggregateTick.Target = nullptr;
+	Movements.Reset();
+	PrerequisiteRefs.Reset();
+	PendingPushes.Reset();
+
+	Super::Deinitialize();
+}
+
+UPBMovementTickSubsystem::FRegisteredMovement* UPBMovementTickSubsystem::FindEntry(const UPBPlayerMovement* Movement)
+{
+	return Movements.FindByPredicate([Movement](const FRegisteredMovement& Entry) { return Entry.Movement.Get() == Movement; });
+}
+
+void UPBMovementTickSubsystem::RegisterMovement(UPBPlayerMovement* Movement, bool bTickEnabled)
+{
+	if (!Movement || FindEntry(Movement))
+	{
+		return;
+	}
+
+	if (!AggregateTick.IsTickFunctionRegistered())
+	{
+		UWorld* World = GetWorld();
+		if (!World || !World->PersistentLevel)
+		{
+			return;
+		}
+		// Same slot in the frame as the component ticks we replace
+		AggregateTick.Target = this;
+		AggregateTick.TickGroup = TG_PrePhysics;
+		AggregateTick.bCanEverTick = true;
+		AggregateTick.bStartWithTickEnabled = true;
+		AggregateTick.bTickEvenWhenPaused = false;
+		AggregateTick.bRunOnAnyThread = false;
+		AggregateTick.RegisterTickFunction(World->PersistentLevel);
+	}
+
+	// Added at the end, so a pawn spawned while ticking starts ticking next frame
+	FRegisteredMovement& Entry = Movements.AddDefaulted_GetRef();
+	Entry.Movement = Movement;
+	Entry.bTickEnabled = bTickEnabled;
+	SyncPrerequisites(Entry);
+	RedirectDependents(Entry);
+}
+
+void UPBMovementTickSubsystem::UnregisterMovement(UPBPlayerMovement* Movement)
+{
+	const int32 Index = Movements.IndexOfByPredicate([Movement](const FRegisteredMovement& Entry) { return Entry.Movement.Get() == Movement; });
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	ReleaseEntry(Movements[Index]);
+
+	// A pawn can be destroyed during its own move, e.g. falling out of the world, so don't shift the entries under the loop
+	if (bIsTickingMovements)
+	{
+		Movements[Index].Movement.Reset();
+		bHasClearedMovements = true;
+	}
+	else
+	{
+		// Removing keeps the remaining entries in registration order
+		Movements.RemoveAt(Index);
+	}
+}
+
+void UPBMovementTickSubsystem::SetMovementTickEnabled(UPBPlayerMovement* Movement, bool bEnabled)
+{
+	if (FRegisteredMovement* Entry = FindEntry(Movement))
+	{
+		Entry->bTickEnabled = bEnabled;
+		Entry->PendingDeltaTime = 0.0f;
+	}
+}
+
+void UPBMovementTickSubsystem::ReleaseEntry(FRegisteredMovement& Entry)
+{
+	for (const FTickPrerequisite& Prerequisite : Entry.Prerequisites)
+	{
+		ReleasePrerequisiteRef(Prerequisite);
+	}
+	Entry.Prerequisites.Reset();
+	RestoreDependents(Entry);
+}
+
+void UPBMovementTickSubsystem::SyncPrerequisites(FRegisteredMovement& Entry)
+{
+	// Controllers add themselves as prerequisites of their pawn's movement on possession, and remove themselves on unpossession
+	const TArray<FTickPrerequisite>& Prerequisites = Entry.Movement->PrimaryComponentTick.GetPrerequisites();
+	for (int32 Index = Entry.Prerequisites.Num() - 1; Index >= 0; Index--)
+	{
+		if (!Prerequisites.Contains(Entry.Prerequisites[Index]))
+		{
+			ReleasePrerequisiteRef(Entry.Prerequisites[Index]);
+			Entry.Prerequisites.RemoveAtSwap(Index);
+		}
+	}
+	for (const FTickPrerequisite& Prerequisite : Prerequisites)
+	{
+		if (Prerequisite.PrerequisiteObject.IsValid() && !Entry.Prerequisites.Contains(Prerequisite))
+		{
+			AddPrerequisiteRef(Prerequisite);
+			Entry.Prerequisites.Add(Prerequisite);
+		}
+	}
+}
+
+void UPBMovementTickSubsystem::AddPrerequisiteRef(const FTickPrerequisite& Prerequisite)
+{
+	int32& RefCount = PrerequisiteRefs.FindOrAdd(Prerequisite.PrerequisiteTickFunction);
+	if (RefCount++ == 0)
+	{
+		AggregateTick.AddPrerequisite(Prerequisite.PrerequisiteObject.Get(), *Prerequisite.PrerequisiteTickFunction);
+	}
+}
+
+void UPBMovementTickSubsystem::ReleasePrerequisiteRef(const FTickPrerequisite& Prerequisite)
+{
+	int32* RefCount = PrerequisiteRefs.Find(Prerequisite.PrerequisiteTickFunction);
+	if (!RefCount || --(*RefCount) > 0)
+	{
+		return;
+	}
+	PrerequisiteRefs.Remove(Prerequisite.PrerequisiteTickFunction);
+	// A prerequisite whose object is gone is skipped when queuing, and can't be matched for removal anyway
+	if (UObject* PrerequisiteObject = Prerequisite.PrerequisiteObject.Get())
+	{
+		AggregateTick.RemovePrerequisite(PrerequisiteObject, *Prerequisite.PrerequisiteTickFunction);
+	}
+}
+
+void UPBMovementTickSubsystem::RedirectDependents(FRegisteredMovement& Entry)
+{
+	UPBPlayerMovement* Movement = Entry.Movement.Get();
+	AActor* Owner = Movement ? Movement->GetOwner() : nullptr;
+	if (!Owner)
+	{
+		return;
+	}
+
+	// The engine keeps no list of what waits on a tick, but the ones that matter, like the character's mesh, are on the owner.
+	// A disabled prerequisite is ignored, so left alone they would tick before we moved the pawn.
+	auto Redirect = [this, Movement, &Entry](UObject* Dependent, FTickFunction& DependentTick)
+	{
+		if (DependentTick.GetPrerequisites().Contains(FTickPrerequisite(Movement, Movement->PrimaryComponentTick)))
+		{
+			DependentTick.RemovePrerequisite(Movement, Movement->PrimaryComponentTick);
+			DependentTick.AddPrerequisite(this, AggregateTick);
+			Entry.Dependents.Add(Dependent);
+		}
+	};
+
+	Redirect(Owner, Owner->PrimaryActorTick);
+	for (UActorComponent* Component : Owner->GetComponents())
+	{
+		if (Component && Component != Movement)
+		{
+			Redirect(Component, Component->PrimaryComponentTick);
+		}
+	}
+}
+
+void UPBMovementTickSubsystem::RestoreDependents(FRegisteredMovement& Entry)
+{
+	UPBPlayerMovement* Movement = Entry.Movement.Get();
+	if (!Movement)
+	{
+		Entry.Dependents.Reset();
+		return;
+	}
+
+	for (const TWeakObjectPtr<UObject>& DependentPtr : Entry.Dependents)
+	{
+		UObject* Dependent = DependentPtr.Get();
+		FTickFunction* DependentTick = nullptr;
+		if (AActor* Actor = Cast<AActor>(Dependent))
+		{
+			DependentTick = &Actor->PrimaryActorTick;
+		}
+		else if (UActorComponent* Component = Cast<UActorComponent>(Dependent))
+		{
+			DependentTick = &Component->PrimaryComponentTick;
+		}
+		if (DependentTick)
+		{
+			DependentTick->RemovePrerequisite(this, AggregateTick);
+			DependentTick->AddPrerequisite(Movement, Movement->PrimaryComponentTick);
+		}
+	}
+	Entry.Dependents.Reset();
+}
+
+void UPBMovementTickSubsystem::TickMovements(float DeltaTime, ELevelTick TickType)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PBAggregatedMovementTick);
+
+#if STATS
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	uint64 ComponentCycles = 0;
+#endif
+
+	int32 NumTicked = 0;
+	{
+		// Ticking can register and unregister pawns: new ones are appended past NumToTick, and removed ones are only cleared
+		TGuardValue<bool> TickingGuard(bIsTickingMovements, true);
+		const int32 NumToTick = Movements.Num();
+		for (int32 Index = 0; Index < NumToTick; Index++)
+		{
+			// Don't hold a reference to the entry across the tick, registering may reallocate the array
+			FRegisteredMovement& Entry = Movements[Index];
+			UPBPlayerMovement* Movement = Entry.Movement.Get();
+			if (!Movement)
+			{
+				// Collected without unregistering, or unregistered earlier in the loop
+				ReleaseEntry(Entry);
+				bHasClearedMovements = true;
+				continue;
+			}
+			if (!Movement->IsRegistered() || Movement->IsPendingKill() || !Entry.bTickEnabled || !Movement->IsActive())
+			{
+				continue;
+			}
+			SyncPrerequisites(Entry);
+
+			// Mirror FActorComponentTickFunction: honor the tick interval, and scale by the owner's time dilation
+			const float TickInterval = Movement->PrimaryComponentTick.TickInterval;
+			if (TickInterval > 0.0f)
+			{
+				Entry.PendingDeltaTime += DeltaTime;
+				if (Entry.PendingDeltaTime < TickInterval)
+				{
+					continue;
+				}
+			}
+			float ComponentDeltaTime = TickInterval > 0.0f ? Entry.PendingDeltaTime : DeltaTime;
+			Entry.PendingDeltaTime = 0.0f;
+			if (const AActor* Owner = Movement->GetOwner())
+			{
+				ComponentDeltaTime *= Owner->CustomTimeDilation;
+			}
+
+#if STATS
+			const uint64 ComponentStartCycles = FPlatformTime::Cycles64();
+#endif
+			Movement->TickComponent(ComponentDeltaTime, TickType, &Movement->PrimaryComponentTick);
+#if STATS
+			ComponentCycles += FPlatformTime::Cycles64() - ComponentStartCycles;
+#endif
+			++NumTicked;
+		}
+	}
+
+	// Drop the entries of pawns that went away during the loop
+	if (bHasClearedMovements)
+	{
+		Movements.RemoveAll([](const FRegisteredMovement& Entry) { return !Entry.Movement.IsValid(); });
+		bHasClearedMovements = false;
+	}
+
+	// Everything has moved, push the bodies we hit before physics runs
+	FlushPushes();
+
+	INC_DWORD_STAT_BY(STAT_PBAggregatedMovementPawns, NumTicked);
+#if STATS
+	if (NumTicked > 0)
+	{
+		const uint64 OverheadCycles = (FPlatformTime::Cycles64() - StartCycles) - ComponentCycles;
+		INC_FLOAT_STAT_BY(STAT_PBAggregatedTickOverheadPerPawn, FPlatformTime::ToMilliseconds64(OverheadCycles) * 1000.0 / NumTicked);
+	}
+#endif
+}
+
+void UPBMovementTickSubsystem::QueuePush(UPrimitiveComponent* Component, FName BoneName, const FVector& Push, const FVector& Location, bool bImpulse)
+{
+	INC_DWORD_STAT(STAT_PBPushesQueued);
+
+	FPendingPush* Pending = PendingPushes.Find(TPair<const UPrimitiveComponent*, FName>(Component, BoneName));
+	if (Pending)
+	{
+		INC_DWORD_STAT(STAT_PBPushesMerged);
+	}
+	else
+	{
+		Pending = &PendingPushes.Add(TPair<const UPrimitiveComponent*, FName>(Component, BoneName));
+		Pending->Component = Component;
+		Pending->BoneName = BoneName;
+		Pending->CenterOfMass = Component->GetCenterOfMass(BoneName);
+	}
+
+	// A push at a location is the same push at the center of mass plus a turn about it
+	const FVector Moment = (Location - Pending->CenterOfMass) ^ Push;
+	if (bImpulse)
+	{
+		Pending->Impulse += Push;
+		Pending->AngularImpulse += Moment;
+		Pending->bHasImpulse = true;
+	}
+	else
+	{
+		Pending->Force += Push;
+		Pending->Torque += Moment;
+		Pending->bHasForce = true;
+	}
+}
+
+void UPBMovementTickSubsystem::FlushPushes()
+{
+	for (const TPair<TPair<const UPrimitiveComponent*, FName>, FPendingPush>& Pair : PendingPushes)
+	{
+		const FPendingPush& Pending = Pair.Value;
+		UPrimitiveComponent* Component = Pending.Component.Get();
+		if (!Component)
+		{
+			continue;
+		}
+
+		if (Pending.bHasImpulse)
+		{
+			Component->AddImpulse(Pending.Impulse, Pending.BoneName);
+			Component->AddAngularImpulseInRadians(Pending.AngularImpulse, Pending.BoneName);
+			INC_DWORD_STAT(STAT_PBPushesApplied);
+		}
+		if (Pending.bHasForce)
+		{
+			Component->AddForce(Pending.Force, Pending.BoneName);
+			Component->AddTorqueInRadians(Pending.Torque, Pending.BoneName);
+			INC_DWORD_STAT(STAT_PBPushesApplied);
+		}
+	}
+	PendingPushes.Reset();
+}
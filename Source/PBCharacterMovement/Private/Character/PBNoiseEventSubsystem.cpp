@@ -0,0 +1,45 @@
+// Copyright Project Borealis
+
+#include "Character/PBNoiseEventSubsystem.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Noise Events Published"), STAT_PBNoiseEventsPublished, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Noise Events Read"), STAT_PBNoiseEventsRead, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Noise Events Missed"), STAT_PBNoiseEventsMissed, STATGROUP_Character);
+
+void UPBNoiseEventSubsystem::Publish(const FPBNoiseEvent& Event)
+{
+	check(IsInGameThread());
+
+	Events[WriteIndex & IndexMask] = Event;
+	WriteIndex++;
+
+	INC_DWORD_STAT(STAT_PBNoiseEventsPublished);
+}
+
+int32 UPBNoiseEventSubsystem::ReadEvents(uint64& Cursor, const FVector& Origin, float Radius, TArray<FPBNoiseEvent>& OutEvents) const
+{
+	check(IsInGameThread());
+
+	const uint64 Head = WriteIndex;
+
+	// Skip what has already been overwritten. All of the last Capacity noises are still there.
+	if (Head - Cursor > Capacity)
+	{
+		INC_DWORD_STAT_BY(STAT_PBNoiseEventsMissed, Head - Cursor - Capacity);
+		Cursor = Head - Capacity;
+	}
+
+	int32 NumRead = 0;
+	for (; Cursor < Head; Cursor++)
+	{
+		const FPBNoiseEvent& Event = Events[Cursor & IndexMask];
+		if (FVector::DistSquared(Event.Location, Origin) <= FMath::Square(Radius * Event.Loudness))
+		{
+			OutEvents.Add(Event);
+			NumRead++;
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_PBNoiseEventsRead, NumRead);
+	return NumRead;
+}
@@ -0,0 +1,182 @@
+// Copyright Project Borealis
+
+#include "Character/PBPathQuerySubsystem.h"
+
+#include "Engine/World.h"
+#include "NavMesh/NavMeshPath.h"
+#include "NavMesh/RecastNavMesh.h"
+#include "NavigationSystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("PB Path Query Tick"), STAT_PBPathQueryTick, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Path Queries Requested"), STAT_PBPathQueriesRequested, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Path Queries Run"), STAT_PBPathQueriesRun, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Path Queries Merged"), STAT_PBPathQueriesMerged, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Path Queries Reused"), STAT_PBPathQueriesReused, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Path Queries Off Navmesh"), STAT_PBPathQueriesOffNavmesh, STATGROUP_Character);
+
+void UPBPathQuerySubsystem::Deinitialize()
+{
+	PendingQueries.Reset();
+	CachedResults.Reset();
+
+	Super::Deinitialize();
+}
+
+UPBPathQuerySubsystem::FQueryKey UPBPathQuerySubsystem::MakeKey(const FVector& Start, const FVector& End, const ANavigationData* NavData)
+{
+	const float CellSize = FMath::Max(QuantizeSize, 1.0f);
+	FQueryKey Key;
+	Key.StartCell = FIntVector(FMath::FloorToInt(Start.X / CellSize), FMath::FloorToInt(Start.Y / CellSize), FMath::FloorToInt(Start.Z / CellSize));
+	Key.EndCell = FIntVector(FMath::FloorToInt(End.X / CellSize), FMath::FloorToInt(End.Y / CellSize), FMath::FloorToInt(End.Z / CellSize));
+	Key.StartPoly = INVALID_NAVNODEREF;
+	Key.EndPoly = INVALID_NAVNODEREF;
+	Key.NavData = NavData;
+	Key.Unique = 0;
+
+	// Within one cell, points can still be on opposite sides of a thin wall or in different corridors
+	if (const ARecastNavMesh* NavMesh = Cast<const ARecastNavMesh>(NavData))
+	{
+		const FVector Extent = NavMesh->GetConfig().DefaultQueryExtent;
+		const FSharedConstNavQueryFilter Filter = NavMesh->GetDefaultQueryFilter();
+		Key.StartPoly = NavMesh->FindNearestPoly(Start, Extent, Filter);
+		Key.EndPoly = Key.StartPoly != INVALID_NAVNODEREF ? NavMesh->FindNearestPoly(End, Extent, Filter) : INVALID_NAVNODEREF;
+	}
+	if (Key.StartPoly == INVALID_NAVNODEREF || Key.EndPoly == INVALID_NAVNODEREF)
+	{
+		INC_DWORD_STAT(STAT_PBPathQueriesOffNavmesh);
+		// Skip zero, which the mergeable keys use
+		Key.Unique = ++LastUnique != 0 ? LastUnique : ++LastUnique;
+	}
+	return Key;
+}
+
+FNavPathSharedPtr UPBPathQuerySubsystem::CopyPath(const FNavPathSharedPtr& Path, const FVector& Start, const FVector& End)
+{
+	if (!Path.IsValid())
+	{
+		return nullptr;
+	}
+
+	// Path following changes its path (observers, shortcuts, start point updates), so requests can't share one
+	FNavPathSharedPtr Copy;
+	if (const FNavMeshPath* MeshPath = Path->CastPath<FNavMeshPath>())
+	{
+		Copy = MakeShared<FNavMeshPath, ESPMode::ThreadSafe>(*MeshPath);
+	}
+	else
+	{
+		Copy = MakeShared<FNavigationPath, ESPMode::ThreadSafe>(*Path);
+	}
+
+	// Merged requests are on the same start and end polys as the searched points, so the legs to their own points stay on the navmesh
+	TArray<FNavPathPoint>& Points = Copy->GetPathPoints();
+	if (Points.Num() >= 2)
+	{
+		Points[0].Location = Start;
+		Points.Last().Location = End;
+	}
+	return Copy;
+}
+
+void UPBPathQuerySubsystem::RequestPath(const FVector& Start, const FVector& End, const FNavAgentProperties& AgentProperties, FPBPathQueryComplete OnComplete)
+{
+	INC_DWORD_STAT(STAT_PBPathQueriesRequested);
+
+	const UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const ANavigationData* NavData = NavSys ? NavSys->GetNavDataForProps(AgentProperties) : nullptr;
+	if (!NavData)
+	{
+		OnComplete.ExecuteIfBound(nullptr);
+		return;
+	}
+
+	const FQueryKey Key = MakeKey(Start, End, NavData);
+
+	if (const FCachedResult* Cached = CachedResults.Find(Key))
+	{
+		if (GetWorld()->GetTimeSeconds() - Cached->Time <= ResultLifetime)
+		{
+			INC_DWORD_STAT(STAT_PBPathQueriesReused);
+			OnComplete.ExecuteIfBound(CopyPath(Cached->Path, Start, End));
+			return;
+		}
+		CachedResults.Remove(Key);
+	}
+
+	if (FPendingQuery* Pending = PendingQueries.Find(Key))
+	{
+		INC_DWORD_STAT(STAT_PBPathQueriesMerged);
+		Pending->Requests.Add({Start, End, MoveTemp(OnComplete)});
+		return;
+	}
+
+	FPendingQuery& Query = PendingQueries.Add(Key);
+	Query.Start = Start;
+	Query.End = End;
+	Query.Requests.Add({Start, End, MoveTemp(OnComplete)});
+}
+
+void UPBPathQuerySubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PBPathQueryTick);
+
+	UWorld* World = GetWorld();
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+	const float Now = World->GetTimeSeconds();
+
+	// Drop expired results so the cache doesn't grow with every place bots have been
+	for (auto It = CachedResults.CreateIterator(); It; ++It)
+	{
+		if (Now - It.Value().Time > ResultLifetime)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	// Take this frame's batch out first, callbacks may queue new requests
+	TArray<TPair<FQueryKey, FPendingQuery>, TInlineAllocator<16>> Batch;
+	for (auto It = PendingQueries.CreateIterator(); It && Batch.Num() < MaxQueriesPerTick; ++It)
+	{
+		Batch.Emplace(It.Key(), MoveTemp(It.Value()));
+		It.RemoveCurrent();
+	}
+
+	for (TPair<FQueryKey, FPendingQuery>& Entry : Batch)
+	{
+		const FQueryKey& Key = Entry.Key;
+		const FPendingQuery& Query = Entry.Value;
+
+		FNavPathSharedPtr Path;
+		if (NavSys && Key.NavData)
+		{
+			const FPathFindingQuery PathQuery(nullptr, *Key.NavData, Query.Start, Query.End, Key.NavData->GetDefaultQueryFilter());
+			const FPathFindingResult Result = NavSys->FindPathSync(PathQuery);
+			if (Result.IsSuccessful())
+			{
+				Path = Result.Path;
+			}
+			INC_DWORD_STAT(STAT_PBPathQueriesRun);
+		}
+
+		// Unmergeable requests can't be asked for again
+		if (Key.Unique == 0)
+		{
+			CachedResults.Add(Key, {Path, Now});
+		}
+		for (const FRequest& Request : Query.Requests)
+		{
+			Request.OnComplete.ExecuteIfBound(CopyPath(Path, Request.Start, Request.End));
+		}
+	}
+}
+
+ETickableTickType UPBPathQuerySubsystem::GetTickableTickType() const
+{
+	// The class default object shouldn't tick
+	return HasAnyFlags(RF_ClassDefaultObject) ? ETickableTickType::Never : ETickableTickType::Always;
+}
+
+TStatId UPBPathQuerySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPBPathQuerySubsystem, STATGROUP_Tickables);
+}
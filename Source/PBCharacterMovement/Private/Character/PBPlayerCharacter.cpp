@@ -12,8 +12,11 @@
 #include "Components/CapsuleComponent.h"
 #include "HAL/IConsoleManager.h"
 #include "Engine/World.h"
+#include "Net/UnrealNetwork.h"
 
+#include "Character/PBCameraEffectsComponent.h"
 #include "Character/PBPlayerMovement.h"
+#include "Sound/PBMoveStepSoundSubsystem.h"
 
 static TAutoConsoleVariable<int32> CVarAutoBHop(TEXT("move.Pogo"), 1, TEXT("If holding spacebar should make the player jump whenever possible.\n"), ECVF_Default);
 
@@ -51,6 +54,8 @@ APBPlayerCharacter::APBPlayerCharacter(const FObjectInitializer& ObjectInitializ
 	// get pointer to movement component
 	MovementPtr = Cast<UPBPlayerMovement>(ACharacter::GetMovementComponent());
 
+	CameraEffects = CreateDefaultSubobject<UPBCameraEffectsComponent>(TEXT("CameraEffects"));
+
 	CapDamageMomentumZ = 476.25f;
 }
 
@@ -60,6 +65,16 @@ void APBPlayerCharacter::BeginPlay()
 	Super::BeginPlay();
 	// Max jump time to get to the top of the arc
 	MaxJumpTime = -4.0f * GetCharacterMovement()->JumpZVelocity / (3.0f * GetCharacterMovement()->GetGravityZ());
+	// Generate the jump reachability tables up front, rather than on a bot's first query
+	if (HasAuthority() && MovementPtr)
+	{
+		MovementPtr->GetJumpReachability();
+	}
+	// Stream in the step sounds for the surfaces this level uses
+	if (UPBMoveStepSoundSubsystem* MoveStepSoundSubsystem = UWorld::GetSubsystem<UPBMoveStepSoundSubsystem>(GetWorld()))
+	{
+		MoveStepSoundSubsystem->PreloadMoveStepSounds(MoveStepSounds);
+	}
 }
 
 void APBPlayerCharacter::Tick(float DeltaTime)
@@ -74,6 +89,32 @@ void APBPlayerCharacter::Tick(float DeltaTime)
 	}
 }
 
+UPBMoveStepSound* APBPlayerCharacter::GetMoveStepSound(TEnumAsByte<EPhysicalSurface> Surface) const
+{
+	const TSoftClassPtr<UPBMoveStepSound>* MoveStepSound = MoveStepSounds.Find(Surface);
+	return MoveStepSound ? UPBMoveStepSoundSubsystem::ResolveMoveStepSound(GetWorld(), *MoveStepSound) : nullptr;
+}
+
+void APBPlayerCharacter::CalcCamera(float DeltaTime, FMinimalViewInfo& OutResult)
+{
+	Super::CalcCamera(DeltaTime, OutResult);
+
+	if (CameraEffects)
+	{
+		CameraEffects->ApplyToView(DeltaTime, OutResult);
+	}
+}
+
+void APBPlayerCharacter::Landed(const FHitResult& Hit)
+{
+	Super::Landed(Hit);
+
+	if (CameraEffects && IsLocallyControlled())
+	{
+		CameraEffects->AddLandBounce(-GetCharacterMovement()->Velocity.Z);
+	}
+}
+
 void APBPlayerCharacter::ApplyDamageMomentum(float DamageTaken, FDamageEvent const& DamageEvent, APawn* PawnInstigator, AActor* DamageCauser)
 {
 	UDamageType const* const DmgTypeCDO = DamageEvent.DamageTypeClass->GetDefaultObject<UDamageType>();
@@ -178,57 +219,66 @@ void APBPlayerCharacter::OnJumped_Implementation()
 	if (GetWorld()->GetTimeSeconds() >= LastJumpBoostTime + MaxJumpTime && JumpBoost)
 	{
 		LastJumpBoostTime = GetWorld()->GetTimeSeconds();
-		// Boost forward speed on jump
-		FVector Facing = GetActorForwardVector();
-		// Use input direction
-		FVector Input = GetCharacterMovement()->GetCurrentAcceleration();
-		if (JumpBoost != 1)
-		{
-			// Only boost input in the direction of current movement axis (prevents ABH).
-			Input *= FMath::Max(Input.GetSafeNormal2D() | GetCharacterMovement()->Velocity.GetSafeNormal2D(), 0.0f);
-		}
-		float ForwardSpeed = Input | Facing;
-		// Adjust how much the boost is
-		float SpeedBoostPerc = bIsSprinting || bIsCrouched ? 0.1f : 0.5f;
-		// How much we are boosting by
-		float SpeedAddition = FMath::Abs(ForwardSpeed * SpeedBoostPerc);
-		// We can only boost up to this much
-		float MaxBoostedSpeed = GetCharacterMovement()->GetMaxSpeed() + GetCharacterMovement()->GetMaxSpeed() * SpeedBoostPerc;
-		// Calculate new speed
-		float NewSpeed = SpeedAddition + GetMovementComponent()->Velocity.Size2D();
-		float SpeedAdditionNoClamp = SpeedAddition;
-
-		// Scale the boost down if we are going over
-		if (NewSpeed > MaxBoostedSpeed)
+		const FVector JumpBoostedVel = ComputeJumpBoostedVelocity(GetMovementComponent()->Velocity, GetCharacterMovement()->GetCurrentAcceleration(), GetActorForwardVector(), GetCharacterMovement()->GetMaxSpeed(), bIsSprinting || bIsCrouched);
+		if (GetMovementComponent()->Velocity.SizeSquared2D() < JumpBoostedVel.SizeSquared2D())
 		{
-			SpeedAddition -= NewSpeed - MaxBoostedSpeed;
+			GetMovementComponent()->Velocity = JumpBoostedVel;
 		}
+	}
+}
 
-		if (ForwardSpeed < -MovementPtr->GetMaxAcceleration() * FMath::Sin(0.6981f))
-		{
-			// Boost backwards if we're going backwards
-			SpeedAddition *= -1.0f;
-			SpeedAdditionNoClamp *= -1.0f;
-		}
+FVector APBPlayerCharacter::ComputeJumpBoostedVelocity(const FVector& InVelocity, const FVector& Input, const FVector& Facing, float MaxSpeed, bool bReducedBoost) const
+{
+	const int32 JumpBoost = CVarJumpBoost->GetInt();
+	if (!JumpBoost)
+	{
+		return InVelocity;
+	}
 
-		// Boost our velocity
-		FVector JumpBoostedVel = GetMovementComponent()->Velocity + Facing * SpeedAddition;
-		float JumpBoostedSizeSq = JumpBoostedVel.SizeSquared2D();
-		if (CVarBunnyhop.GetValueOnGameThread() != 0)
-		{
-			FVector JumpBoostedUnclampVel = GetMovementComponent()->Velocity + Facing * SpeedAdditionNoClamp;
-			float JumpBoostedUnclampSizeSq = JumpBoostedUnclampVel.SizeSquared2D();
-			if (JumpBoostedUnclampSizeSq > JumpBoostedSizeSq)
-			{
-				JumpBoostedVel = JumpBoostedUnclampVel;
-				JumpBoostedSizeSq = JumpBoostedUnclampSizeSq;
-			}
-		}
-		if (GetMovementComponent()->Velocity.SizeSquared2D() < JumpBoostedSizeSq)
+	// Boost forward speed on jump, using input direction
+	FVector BoostInput = Input;
+	if (JumpBoost != 1)
+	{
+		// Only boost input in the direction of current movement axis (prevents ABH).
+		BoostInput *= FMath::Max(BoostInput.GetSafeNormal2D() | InVelocity.GetSafeNormal2D(), 0.0f);
+	}
+	float ForwardSpeed = BoostInput | Facing;
+	// Adjust how much the boost is
+	float SpeedBoostPerc = bReducedBoost ? 0.1f : 0.5f;
+	// How much we are boosting by
+	float SpeedAddition = FMath::Abs(ForwardSpeed * SpeedBoostPerc);
+	// We can only boost up to this much
+	float MaxBoostedSpeed = MaxSpeed + MaxSpeed * SpeedBoostPerc;
+	// Calculate new speed
+	float NewSpeed = SpeedAddition + InVelocity.Size2D();
+	float SpeedAdditionNoClamp = SpeedAddition;
+
+	// Scale the boost down if we are going over
+	if (NewSpeed > MaxBoostedSpeed)
+	{
+		SpeedAddition -= NewSpeed - MaxBoostedSpeed;
+	}
+
+	if (ForwardSpeed < -MovementPtr->GetMaxAcceleration() * FMath::Sin(0.6981f))
+	{
+		// Boost backwards if we're going backwards
+		SpeedAddition *= -1.0f;
+		SpeedAdditionNoClamp *= -1.0f;
+	}
+
+	// Boost our velocity
+	FVector JumpBoostedVel = InVelocity + Facing * SpeedAddition;
+	float JumpBoostedSizeSq = JumpBoostedVel.SizeSquared2D();
+	if (CVarBunnyhop.GetValueOnAnyThread() != 0)
+	{
+		FVector JumpBoostedUnclampVel = InVelocity + Facing * SpeedAdditionNoClamp;
+		float JumpBoostedUnclampSizeSq = JumpBoostedUnclampVel.SizeSquared2D();
+		if (JumpBoostedUnclampSizeSq > JumpBoostedSizeSq)
 		{
-			GetMovementComponent()->Velocity = JumpBoostedVel;
+			JumpBoostedVel = JumpBoostedUnclampVel;
 		}
 	}
+	return JumpBoostedVel;
 }
 
 void APBPlayerCharacter::ToggleNoClip()
@@ -337,14 +387,35 @@ void APBPlayerCharacter::LookUp(bool bIsPure, float Rate)
 
 void APBPlayerCharacter::RecalculateBaseEyeHeight()
 {
-	const ACharacter* DefaultCharacter = GetClass()->GetDefaultObject<ACharacter>();
-	const float OldUnscaledHalfHeight = DefaultCharacter->GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight();
-	const float CrouchedHalfHeight = GetCharacterMovement()->CrouchedHalfHeight;
-	const float FullCrouchDiff = OldUnscaledHalfHeight - CrouchedHalfHeight;
-	const UCapsuleComponent* CharacterCapsule = GetCapsuleComponent();
-	const float CurrentUnscaledHalfHeight = CharacterCapsule->GetUnscaledCapsuleHalfHeight();
-	const float CurrentAlpha = 1.0f - (CurrentUnscaledHalfHeight - CrouchedHalfHeight) / FullCrouchDiff;
-	BaseEyeHeight = FMath::Lerp(DefaultCharacter->BaseEyeHeight, CrouchedEyeHeight, SimpleSpline(CurrentAlpha));
+	if (!MovementPtr || !GetCapsuleComponent())
+	{
+		Super::RecalculateBaseEyeHeight();
+		return;
+	}
+	// The capsule is already eased by the crouch curve, so following its alpha linearly keeps the eyes in step with it
+	const FPBCrouchGeometry& CrouchGeometry = MovementPtr->GetCrouchGeometry();
+	BaseEyeHeight = FMath::Lerp(CrouchGeometry.StandingEyeHeight, CrouchGeometry.CrouchedEyeHeight, MovementPtr->GetCrouchAlpha());
+}
+
+void APBPlayerCharacter::SetReplicatedCrouchAlpha(float InCrouchAlpha)
+{
+	ReplicatedCrouchAlpha = FMath::Quantize8UnsignedByte(InCrouchAlpha);
+}
+
+void APBPlayerCharacter::OnRep_CrouchAlpha()
+{
+	if (MovementPtr)
+	{
+		MovementPtr->SetSimulatedCrouchAlpha(ReplicatedCrouchAlpha / 255.0f);
+		RecalculateBaseEyeHeight();
+	}
+}
+
+void APBPlayerCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME_CONDITION(APBPlayerCharacter, ReplicatedCrouchAlpha, COND_SimulatedOnly);
 }
 
 bool APBPlayerCharacter::CanCrouch() const
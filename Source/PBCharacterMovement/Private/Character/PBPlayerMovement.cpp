@@ -2,24 +2,61 @@
 
 #include "Character/PBPlayerMovement.h"
 
+#include "AudioDevice.h"
 #include "Components/CapsuleComponent.h"
 #include "Engine/Engine.h"
 #include "Engine/World.h"
 #include "GameFramework/Character.h"
 #include "HAL/IConsoleManager.h"
 #include "Kismet/GameplayStatics.h"
+#include "Misc/Crc.h"
 #include "PhysicalMaterials/PhysicalMaterial.h"
 #include "PhysicsEngine/PhysicsSettings.h"
 #include "Sound/SoundCue.h"
 #include "ProfilingDebugging/CsvProfiler.h"
 
 #include "Sound/PBMoveStepSound.h"
+#include "Sound/PBMoveStepSoundSubsystem.h"
+#include "Character/PBCorrectionTelemetrySubsystem.h"
+#include "Character/PBJumpReachabilitySubsystem.h"
+#include "Character/PBLadderSubsystem.h"
+#include "Character/PBLadderVolume.h"
+#include "Character/PBMovementTickSubsystem.h"
+#include "Character/PBNoiseEventSubsystem.h"
 #include "Character/PBPlayerCharacter.h"
+#include "Character/PBSavedMove.h"
 
 static TAutoConsoleVariable<int32> CVarShowPos(TEXT("cl.ShowPos"), 0, TEXT("Show position and movement information.\n"), ECVF_Default);
 
 DECLARE_CYCLE_STAT(TEXT("Char StepUp"), STAT_CharStepUp, STATGROUP_Character);
 DECLARE_CYCLE_STAT(TEXT("Char PhysFalling"), STAT_CharPhysFalling, STATGROUP_Character);
+DECLARE_CYCLE_STAT(TEXT("PB PhysLadder"), STAT_PBPhysLadder, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB StepUp Flat Base"), STAT_PBStepUpFlatBase, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB StepUp Fallback"), STAT_PBStepUpFallback, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB StepUp Flat Base Queries"), STAT_PBStepUpFlatBaseQueries, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB PhysFalling Ticks"), STAT_PBPhysFallingTicks, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Airborne Move Queries"), STAT_PBAirborneMoveQueries, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Anticipation Traces"), STAT_PBAnticipationTraces, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Falling FindFloor Calls"), STAT_PBFallingFindFloorCalls, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Landing Spot Memo Hits"), STAT_PBLandingSpotMemoHits, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Crouched Pawn Ticks"), STAT_PBCrouchedPawnTicks, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Uncrouch Overlap Tests"), STAT_PBUncrouchOverlapTests, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Uncrouch Overlap Tests Skipped"), STAT_PBUncrouchOverlapTestsSkipped, STATGROUP_Character);
+DECLARE_MEMORY_STAT(TEXT("PB Capsule History Memory"), STAT_PBCapsuleHistoryMemory, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Capsule History Samples"), STAT_PBCapsuleHistorySamples, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Steps"), STAT_PBSteps, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Footstep Traces Culled"), STAT_PBFootstepTracesCulled, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB ServerMove RPCs"), STAT_PBServerMoveRPCs, STATGROUP_Character);
+DECLARE_CYCLE_STAT(TEXT("PB PredictTrajectory"), STAT_PBPredictTrajectory, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Adaptive Air Substeps"), STAT_PBAdaptiveAirSubsteps, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Falling Unresolved Penetrations"), STAT_PBFallingPenetrations, STATGROUP_Character);
+DECLARE_CYCLE_STAT(TEXT("PB Query Params"), STAT_PBQueryParams, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Query Params Built"), STAT_PBQueryParamsBuilt, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Query Params Reused"), STAT_PBQueryParamsReused, STATGROUP_Character);
+DECLARE_CYCLE_STAT(TEXT("PB Based Movement"), STAT_PBBasedMovement, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Based Pawns"), STAT_PBBasedPawns, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Based Floor Reuses"), STAT_PBBasedFloorReuses, STATGROUP_Character);
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Based Floor Queries"), STAT_PBBasedFloorQueries, STATGROUP_Character);
 
 // MAGIC NUMBERS
 constexpr float JumpVelocity = 266.7f;
@@ -63,6 +100,9 @@ UPBPlayerMovement::UPBPlayerMovement()
 	// Avoid breaking up time step
 	MaxSimulationTimeStep = 0.5f;
 	MaxSimulationIterations = 1;
+	bUseAdaptiveAirSubstepping = true;
+	AdaptiveSubstepRadiusFraction = 0.5f;
+	MaxAdaptiveSubsteps = 4;
 	// Braking deceleration (sv_stopspeed)
 	FallingLateralFriction = 0.0f;
 	BrakingDecelerationFalling = 0.0f;
@@ -86,6 +126,15 @@ UPBPlayerMovement::UPBPlayerMovement()
 	bOnLadder = false;
 	OffLadderTicks = LADDER_MOUNT_TIMEOUT;
 	LadderSpeed = 381.0f;
+	LadderJumpOffSpeed = 514.35f;
+	// Strides match the old fixed step timings at each state's nominal speed
+	WalkStrideLength = WalkSpeed * 0.4f;
+	RunStrideLength = RunSpeed * 0.4f;
+	SprintStrideLength = SprintSpeed * 0.3f;
+	CrouchStrideLength = RunSpeed * 0.33333333f * 0.5f;
+	LadderStrideLength = LadderSpeed * 0.45f;
+	WalkNoiseLoudness = 0.2f;
+	SprintNoiseLoudness = 0.5f;
 	// Speed multiplier bounds
 	SpeedMultMin = SprintSpeed * 1.7f;
 	SpeedMultMax = SprintSpeed * 2.5f;
@@ -101,6 +150,10 @@ UPBPlayerMovement::UPBPlayerMovement()
 	UncrouchTime = MOVEMENT_DEFAULT_UNCROUCHTIME;
 	CrouchJumpTime = MOVEMENT_DEFAULT_CROUCHJUMPTIME;
 	UncrouchJumpTime = MOVEMENT_DEFAULT_UNCROUCHJUMPTIME;
+	CrouchEasing = EPBCrouchEasing::SimpleSpline;
+	UncrouchEasing = EPBCrouchEasing::SimpleSpline;
+	CrouchJumpEasing = EPBCrouchEasing::SimpleSpline;
+	UncrouchJumpEasing = EPBCrouchEasing::SimpleSpline;
 	// Slope angle is 45.57 degrees
 	SetWalkableFloorZ(0.7f);
 	DefaultWalkableFloorZ = GetWalkableFloorZ();
@@ -144,6 +197,243 @@ void UPBPlayerMovement::InitializeComponent()
 {
 	Super::InitializeComponent();
 	PBCharacter = Cast<APBPlayerCharacter>(GetOwner());
+	UpdateCrouchGeometry();
+	SetRandomSeed(RandomSeed);
+}
+
+void UPBPlayerMovement::SetRandomSeed(int32 InRandomSeed)
+{
+	RandomSeed = InRandomSeed;
+	// The movement stream is reseeded from this on every move, see PerformMovement
+	MoveRandomStream.Initialize((uint32)RandomSeed);
+	// Name based, rather than FName hash based, so the seed is the same every run. Names differ between server and client, which is fine for cosmetics.
+	const uint32 CosmeticSeed = RandomSeed != 0 ? (uint32)RandomSeed : (GetOwner() ? FCrc::StrCrc32(*GetOwner()->GetName()) : 0);
+	CosmeticRandomStream.Initialize(CosmeticSeed);
+}
+
+const FPBCrouchGeometry& UPBPlayerMovement::GetCrouchGeometry() const
+{
+	const ACharacter* Character = CharacterOwner ? CharacterOwner : Cast<ACharacter>(GetOwner());
+	const UCapsuleComponent* CharacterCapsule = Character ? Character->GetCapsuleComponent() : nullptr;
+	// Rebuild if the capsule was rescaled or the crouch tuning changed since
+	if (!CrouchGeometry.bValid || (CharacterCapsule && CharacterCapsule->GetShapeScale() != CrouchGeometry.ShapeScale) || CrouchedHalfHeight != CrouchGeometry.CrouchedHalfHeight ||
+		(Character && Character->CrouchedEyeHeight != CrouchGeometry.CrouchedEyeHeight))
+	{
+		UpdateCrouchGeometry();
+	}
+	return CrouchGeometry;
+}
+
+void UPBPlayerMovement::UpdateCrouchGeometry() const
+{
+	const ACharacter* Character = CharacterOwner ? CharacterOwner : Cast<ACharacter>(GetOwner());
+	if (!Character || !Character->GetCapsuleComponent())
+	{
+		return;
+	}
+
+	const ACharacter* DefaultCharacter = Character->GetClass()->GetDefaultObject<ACharacter>();
+	const UCapsuleComponent* DefaultCapsule = DefaultCharacter->GetCapsuleComponent();
+	CrouchGeometry.StandingHalfHeight = DefaultCapsule->GetUnscaledCapsuleHalfHeight();
+	CrouchGeometry.CrouchedHalfHeight = CrouchedHalfHeight;
+	CrouchGeometry.Radius = DefaultCapsule->GetUnscaledCapsuleRadius();
+	CrouchGeometry.FullCrouchDiff = CrouchGeometry.StandingHalfHeight - CrouchGeometry.CrouchedHalfHeight;
+	CrouchGeometry.StandingEyeHeight = DefaultCharacter->BaseEyeHeight;
+	CrouchGeometry.CrouchedEyeHeight = Character->CrouchedEyeHeight;
+	CrouchGeometry.ShapeScale = Character->GetCapsuleComponent()->GetShapeScale();
+	CrouchGeometry.bValid = true;
+}
+
+const FPBCrouchCurve& UPBPlayerMovement::GetCrouchCurve(EPBCrouchTransition Transition) const
+{
+	EPBCrouchEasing Easing;
+	switch (Transition)
+	{
+		case EPBCrouchTransition::Crouch:
+			Easing = CrouchEasing;
+			break;
+		case EPBCrouchTransition::Uncrouch:
+			Easing = UncrouchEasing;
+			break;
+		case EPBCrouchTransition::CrouchJump:
+			Easing = CrouchJumpEasing;
+			break;
+		default:
+			Easing = UncrouchJumpEasing;
+			break;
+	}
+
+	FPBCrouchCurve& Curve = CrouchCurves[(int32)Transition];
+	if (!Curve.bBuilt || Curve.Easing != Easing)
+	{
+		Curve.Build(Easing);
+	}
+	return Curve;
+}
+
+const FPBQueryParams& UPBPlayerMovement::GetQueryParams(EPBQueryParams Query)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PBQueryParams);
+
+	FPBQueryParams& Params = QueryParamsCache[(int32)Query];
+	const uint32 Signature = GetQueryParamsSignature();
+	if (Params.bBuilt && Params.Signature == Signature)
+	{
+		INC_DWORD_STAT(STAT_PBQueryParamsReused);
+		return Params;
+	}
+
+	// Building allocates once the ignore lists outgrow their inline storage, so only do it when they change
+	switch (Query)
+	{
+		case EPBQueryParams::FloorComplex:
+			Params.QueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(CharacterFloorTrace), false, CharacterOwner);
+			break;
+		case EPBQueryParams::CrouchOverlap:
+			Params.QueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(CrouchTrace), false, CharacterOwner);
+			break;
+		default:
+			Params.QueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(CapsuleHemisphereTrace), false, CharacterOwner);
+			break;
+	}
+	Params.ResponseParams = FCollisionResponseParams();
+	InitCollisionParams(Params.QueryParams, Params.ResponseParams);
+	if (Query == EPBQueryParams::FloorComplex)
+	{
+		// must trace complex to get mesh phys materials
+		Params.QueryParams.bTraceComplex = true;
+		// must get materials
+		Params.QueryParams.bReturnPhysicalMaterial = true;
+	}
+	Params.Signature = Signature;
+	Params.bBuilt = true;
+	INC_DWORD_STAT(STAT_PBQueryParamsBuilt);
+	return Params;
+}
+
+uint32 UPBPlayerMovement::GetQueryParamsSignature() const
+{
+	uint32 Signature = GetTypeHash(CharacterOwner);
+	if (!UpdatedPrimitive)
+	{
+		return Signature;
+	}
+
+	// Mirrors UPrimitiveComponent::InitSweepCollisionParams
+	const FCollisionResponseContainer& Responses = UpdatedPrimitive->BodyInstance.GetResponseToChannels();
+	Signature = FCrc::MemCrc32(Responses.EnumArray, sizeof(Responses.EnumArray), Signature);
+	Signature = HashCombine(Signature, GetTypeHash(UpdatedPrimitive));
+	for (const AActor* IgnoredActor : UpdatedPrimitive->GetMoveIgnoreActors())
+	{
+		Signature = HashCombine(Signature, GetTypeHash(IgnoredActor));
+	}
+	for (const UPrimitiveComponent* IgnoredComponent : UpdatedPrimitive->GetMoveIgnoreComponents())
+	{
+		Signature = HashCombine(Signature, GetTypeHash(IgnoredComponent));
+	}
+	const uint32 Flags = (uint32)UpdatedPrimitive->GetMoveIgnoreMask() | (UpdatedPrimitive->bTraceComplexOnMove ? 1u << 8 : 0u) | (UpdatedPrimitive->bReturnMaterialOnMove ? 1u << 9 : 0u);
+	return HashCombine(Signature, Flags);
+}
+
+float UPBPlayerMovement::GetCrouchTransitionTime(EPBCrouchTransition Transition) const
+{
+	switch (Transition)
+	{
+		case EPBCrouchTransition::Crouch:
+			return CrouchTime;
+		case EPBCrouchTransition::Uncrouch:
+			return UncrouchTime;
+		case EPBCrouchTransition::CrouchJump:
+			return CrouchJumpTime;
+		default:
+			return UncrouchJumpTime;
+	}
+}
+
+void UPBPlayerMovement::SetCrouchAlpha(float InCrouchAlpha)
+{
+	CrouchAlpha = FMath::Clamp(InCrouchAlpha, 0.0f, 1.0f);
+	if (PBCharacter && PBCharacter->HasAuthority())
+	{
+		PBCharacter->SetReplicatedCrouchAlpha(CrouchAlpha);
+	}
+}
+
+void UPBPlayerMovement::SetSimulatedCrouchAlpha(float InCrouchAlpha)
+{
+	CrouchAlpha = FMath::Clamp(InCrouchAlpha, 0.0f, 1.0f);
+}
+
+void FPBCrouchCurve::Build(EPBCrouchEasing InEasing)
+{
+	Easing = InEasing;
+	for (int32 i = 0; i <= NumSegments; i++)
+	{
+		const float Time = (float)i / NumSegments;
+		switch (Easing)
+		{
+			case EPBCrouchEasing::SimpleSpline:
+				Samples[i] = SimpleSpline(Time);
+				break;
+			case EPBCrouchEasing::EaseIn:
+				Samples[i] = Time * Time;
+				break;
+			case EPBCrouchEasing::EaseOut:
+				Samples[i] = 1.0f - (1.0f - Time) * (1.0f - Time);
+				break;
+			default:
+				Samples[i] = Time;
+				break;
+		}
+	}
+	Samples[0] = 0.0f;
+	Samples[NumSegments] = 1.0f;
+	bBuilt = true;
+}
+
+float FPBCrouchCurve::Evaluate(float Time) const
+{
+	if (Time <= 0.0f)
+	{
+		return 0.0f;
+	}
+	if (Time >= 1.0f)
+	{
+		return 1.0f;
+	}
+	const float Scaled = Time * NumSegments;
+	const int32 Index = FMath::Min(FMath::FloorToInt(Scaled), NumSegments - 1);
+	return FMath::Lerp(Samples[Index], Samples[Index + 1], Scaled - Index);
+}
+
+float FPBCrouchCurve::InverseEvaluate(float Progress) const
+{
+	if (Progress <= 0.0f)
+	{
+		return 0.0f;
+	}
+	if (Progress >= 1.0f)
+	{
+		return 1.0f;
+	}
+	// Samples increase monotonically, so binary search for the segment containing this progress
+	int32 Low = 0;
+	int32 High = NumSegments;
+	while (High - Low > 1)
+	{
+		const int32 Mid = (Low + High) / 2;
+		if (Samples[Mid] <= Progress)
+		{
+			Low = Mid;
+		}
+		else
+		{
+			High = Mid;
+		}
+	}
+	const float SegmentRange = Samples[High] - Samples[Low];
+	const float SegmentAlpha = SegmentRange > KINDA_SMALL_NUMBER ? (Progress - Samples[Low]) / SegmentRange : 0.0f;
+	return (Low + SegmentAlpha) / NumSegments;
 }
 
 void UPBPlayerMovement::OnRegister()
@@ -157,10 +447,194 @@ void UPBPlayerMovement::OnRegister()
 	}
 }
 
+void UPBPlayerMovement::BeginPlay()
+{
+	Super::BeginPlay();
+
+	UWorld* World = GetWorld();
+	if (bUseAggregatedTick && World && World->IsGameWorld() && PrimaryComponentTick.bCanEverTick)
+	{
+		if (UPBMovementTickSubsystem* TickSubsystem = World->GetSubsystem<UPBMovementTickSubsystem>())
+		{
+			// The aggregated tick drives us from now on, so don't let the movement component re-enable our own tick
+			bAutoUpdateTickRegistration = false;
+			const bool bTickEnabled = PrimaryComponentTick.IsTickFunctionEnabled();
+			PrimaryComponentTick.SetTickFunctionEnable(false);
+			TickSubsystem->RegisterMovement(this, bTickEnabled);
+			bIsAggregatedTicking = true;
+		}
+	}
+
+	if (bRecordCapsuleHistory && World && World->IsGameWorld() && !IsNetMode(NM_Client))
+	{
+		CapsuleHistory.Reset();
+		bIsRecordingCapsuleHistory = true;
+		INC_MEMORY_STAT_BY(STAT_PBCapsuleHistoryMemory, sizeof(FPBCapsuleHistory));
+	}
+}
+
+void UPBPlayerMovement::PerformMovement(float DeltaTime)
+{
+	// Server, client and client replays of a move all draw the same movement randomness
+	MoveRandomStream.Initialize(HashCombine((uint32)RandomSeed, GetTypeHash(GetMoveTimeStamp())));
+
+	Super::PerformMovement(DeltaTime);
+}
+
+float UPBPlayerMovement::GetMoveTimeStamp() const
+{
+	if (bInAutonomousMove)
+	{
+		return AutonomousMoveTimeStamp;
+	}
+	// A client's new move is performed after its timestamp is assigned
+	if (CharacterOwner && CharacterOwner->GetLocalRole() == ROLE_AutonomousProxy)
+	{
+		if (const FNetworkPredictionData_Client_Character* ClientData = GetPredictionData_Client_Character())
+		{
+			return ClientData->CurrentTimeStamp;
+		}
+	}
+	// Nothing to agree with
+	const UWorld* World = GetWorld();
+	return World ? World->GetTimeSeconds() : 0.0f;
+}
+
+void UPBPlayerMovement::MoveAutonomous(float ClientTimeStamp, float DeltaTime, uint8 CompressedFlags, const FVector& NewAccel)
+{
+	// Note what PB state changes over this move, in case it needs correcting
+	const bool bWasSprinting = PBCharacter && PBCharacter->IsSprinting();
+	const float OldSurfaceFriction = SurfaceFriction;
+	const bool bWasInCrouchTransition = bIsInCrouchTransition;
+	bCaughtAirThisMove = false;
+
+	{
+		TGuardValue<bool> AutonomousMoveGuard(bInAutonomousMove, true);
+		TGuardValue<float> AutonomousMoveTimeStampGuard(AutonomousMoveTimeStamp, ClientTimeStamp);
+		Super::MoveAutonomous(ClientTimeStamp, DeltaTime, CompressedFlags, NewAccel);
+	}
+
+	PendingCorrectionCauses = EPBCorrectionCause::None;
+	if (bWasInCrouchTransition || bIsInCrouchTransition)
+	{
+		PendingCorrectionCauses |= EPBCorrectionCause::CrouchTransition;
+	}
+	if (PBCharacter && bWasSprinting != PBCharacter->IsSprinting())
+	{
+		PendingCorrectionCauses |= EPBCorrectionCause::SprintChange;
+	}
+	if (!FMath::IsNearlyEqual(OldSurfaceFriction, SurfaceFriction))
+	{
+		PendingCorrectionCauses |= EPBCorrectionCause::FrictionChange;
+	}
+	if (bCaughtAirThisMove)
+	{
+		PendingCorrectionCauses |= EPBCorrectionCause::CatchAir;
+	}
+
+	if (bIsRecordingCapsuleHistory)
+	{
+		RecordCapsuleHistory();
+	}
+}
+
+FNetworkPredictionData_Client* UPBPlayerMovement::GetPredictionData_Client() const
+{
+	if (ClientPredictionData == nullptr)
+	{
+		UPBPlayerMovement* MutableThis = const_cast<UPBPlayerMovement*>(this);
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_PB(*this);
+	}
+
+	return ClientPredictionData;
+}
+
+void UPBPlayerMovement::CallServerMove(const FSavedMove_Character* NewMove, const FSavedMove_Character* OldMove)
+{
+	INC_DWORD_STAT(STAT_PBServerMoveRPCs);
+	Super::CallServerMove(NewMove, OldMove);
+}
+
+bool UPBPlayerMovement::ServerCheckClientError(float ClientTimeStamp, float DeltaTime, const FVector& Accel, const FVector& ClientWorldLocation, const FVector& RelativeClientLocation, UPrimitiveComponent* ClientMovementBase, FName ClientBaseBoneName, uint8 ClientMovementMode)
+{
+	if (!Super::ServerCheckClientError(ClientTimeStamp, DeltaTime, Accel, ClientWorldLocation, RelativeClientLocation, ClientMovementBase, ClientBaseBoneName, ClientMovementMode))
+	{
+		return false;
+	}
+
+	if (UPBCorrectionTelemetrySubsystem* Telemetry = UWorld::GetSubsystem<UPBCorrectionTelemetrySubsystem>(GetWorld()))
+	{
+		EPBCorrectionCause Causes = PendingCorrectionCauses;
+		if (ClientMovementMode != PackNetworkMovementMode())
+		{
+			Causes |= EPBCorrectionCause::MovementMode;
+		}
+		const float Magnitude = (ClientWorldLocation - UpdatedComponent->GetComponentLocation()).Size();
+		Telemetry->RecordCorrection(CharacterOwner->GetNetConnection(), Causes, Magnitude);
+	}
+	return true;
+}
+
+void UPBPlayerMovement::RecordCapsuleHistory()
+{
+	if (!HasValidData())
+	{
+		return;
+	}
+	INC_DWORD_STAT(STAT_PBCapsuleHistorySamples);
+	CapsuleHistory.Record(GetWorld()->GetTimeSeconds(), UpdatedComponent->GetComponentLocation(), UpdatedComponent->GetComponentQuat(), CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleHalfHeight());
+}
+
+bool UPBPlayerMovement::GetCapsuleAtTime(float ServerTime, FPBCapsuleHistorySample& OutSample) const
+{
+	return CapsuleHistory.Rewind(ServerTime, OutSample);
+}
+
+void UPBPlayerMovement::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (bIsAggregatedTicking)
+	{
+		if (UPBMovementTickSubsystem* TickSubsystem = GetWorld() ? GetWorld()->GetSubsystem<UPBMovementTickSubsystem>() : nullptr)
+		{
+			TickSubsystem->UnregisterMovement(this);
+		}
+		bIsAggregatedTicking = false;
+	}
+
+	if (bIsRecordingCapsuleHistory)
+	{
+		DEC_MEMORY_STAT_BY(STAT_PBCapsuleHistoryMemory, sizeof(FPBCapsuleHistory));
+		bIsRecordingCapsuleHistory = false;
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UPBPlayerMovement::SetComponentTickEnabled(bool bEnabled)
+{
+	// Our own tick stays disabled while aggregated, so pass the request on to the aggregated tick (this covers Activate/Deactivate too)
+	if (bIsAggregatedTicking)
+	{
+		if (UPBMovementTickSubsystem* TickSubsystem = UWorld::GetSubsystem<UPBMovementTickSubsystem>(GetWorld()))
+		{
+			TickSubsystem->SetMovementTickEnabled(this, bEnabled);
+			return;
+		}
+	}
+
+	Super::SetComponentTickEnabled(bEnabled);
+}
+
 void UPBPlayerMovement::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {	
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-	PlayMoveSound(DeltaTime);
+	UpdateStepCadence(DeltaTime);
+
+	// Remote clients' moves are recorded as they arrive in MoveAutonomous, everyone else moved in the tick
+	if (bIsRecordingCapsuleHistory && CharacterOwner && CharacterOwner->GetRemoteRole() != ROLE_AutonomousProxy)
+	{
+		RecordCapsuleHistory();
+	}
 
 	if (bHasDeferredMovementMode)
 	{
@@ -181,13 +655,6 @@ void UPBPlayerMovement::TickComponent(float DeltaTime, enum ELevelTick TickType,
 		GEngine->AddOnScreenDebugMessage(3, 1.0f, FColor::Green, FString::Printf(TEXT("vel: %f"), Velocity.Size()));
 	}
 
-	if (RollAngle != 0 && RollSpeed != 0 && PBCharacter->GetController())
-	{
-		FRotator ControlRotation = PBCharacter->GetController()->GetControlRotation();
-		ControlRotation.Roll = GetCameraRoll();
-		PBCharacter->GetController()->SetControlRotation(ControlRotation);
-	}
-	
 	if (IsMovingOnGround())
 	{
 		if (!bBrakingWindowElapsed) BrakingWindowTimeElapsed += DeltaTime * 1000;
@@ -214,6 +681,16 @@ bool UPBPlayerMovement::DoJump(bool bClientSimulation)
 
 	if (!bCheatFlying && CharacterOwner && CharacterOwner->CanJump() )
 	{
+		if (bOnLadder)
+		{
+			// Push off away from the ladder, and don't grab it again straight away
+			const FVector LadderNormal = CurrentLadder.IsValid() ? CurrentLadder->GetLadderNormal() : -UpdatedComponent->GetForwardVector();
+			Velocity = LadderNormal * LadderJumpOffSpeed;
+			OffLadderTicks = LADDER_MOUNT_TIMEOUT;
+			SetMovementMode(MOVE_Falling);
+			return true;
+		}
+
 		// Don't jump if we can't move up/down.
 		if (!bConstrainToPlane || FMath::Abs(PlaneConstraintNormal.Z) != 1.f)
 		{
@@ -235,12 +712,7 @@ bool UPBPlayerMovement::DoJump(bool bClientSimulation)
 
 float GetFrictionFromHit(const FHitResult& Hit)
 {
-	float SurfaceFriction = 1.0f;
-	if (Hit.PhysMaterial.IsValid())
-	{
-		SurfaceFriction = FMath::Min(1.0f, Hit.PhysMaterial->Friction * 1.25f);
-	}
-	return SurfaceFriction;
+	return UPBFloorSurfaceSubsystem::GetFriction(Hit.PhysMaterial.Get());
 }
 
 void UPBPlayerMovement::TwoWallAdjust(FVector& Delta, const FHitResult& Hit, const FVector& OldHitNormal) const
@@ -310,6 +782,7 @@ bool UPBPlayerMovement::ShouldCatchAir(const FFindFloorResult& OldFloor, const F
 
 	if (bSliding && bGainingRamp && bMovingForCatchAir)
 	{
+		bCaughtAirThisMove = true;
 		return true;
 	}
 
@@ -380,9 +853,8 @@ bool UPBPlayerMovement::IsValidLandingSpot(const FVector& CapsuleLocation, const
 			return false;
 		}
 	}
-	FFindFloorResult FloorResult;
-	FindFloor(CapsuleLocation, FloorResult, false, &Hit);
-	if (!FloorResult.IsWalkableFloor())
+	FPBLandingSpotMemo& Memo = FindOrAddLandingSpotMemo(CapsuleLocation, Hit);
+	if (!Memo.FloorResult.IsWalkableFloor())
 	{
 		return false;
 	}
@@ -394,10 +866,15 @@ bool UPBPlayerMovement::IsValidLandingSpot(const FVector& CapsuleLocation, const
 		FVector DeflectionVector = Velocity;
 		// a step of gravity
 		DeflectionVector.Z += 0.5f * GetGravityZ() * GetWorld()->GetDeltaSeconds();
-		DeflectionVector = ComputeSlideVector(DeflectionVector, 1.0f, Hit.Normal, Hit);
+		if (!Memo.bHasDeflection || Memo.DeflectionInput != DeflectionVector)
+		{
+			Memo.DeflectionInput = DeflectionVector;
+			Memo.DeflectionZ = ComputeSlideVector(DeflectionVector, 1.0f, Hit.Normal, Hit).Z;
+			Memo.bHasDeflection = true;
+		}
 
 		// going up too fast to land
-		if (DeflectionVector.Z > JumpVelocity)
+		if (Memo.DeflectionZ > JumpVelocity)
 		{
 			return false;
 		}
@@ -405,15 +882,120 @@ bool UPBPlayerMovement::IsValidLandingSpot(const FVector& CapsuleLocation, const
 	return true;
 }
 
+UPBPlayerMovement::FPBLandingSpotMemo& UPBPlayerMovement::FindOrAddLandingSpotMemo(const FVector& CapsuleLocation, const FHitResult& Hit) const
+{
+	if (bLandingSpotMemoActive)
+	{
+		for (FPBLandingSpotMemo& Memo : LandingSpotMemo)
+		{
+			if (Memo.Matches(CapsuleLocation, Hit))
+			{
+				INC_DWORD_STAT(STAT_PBLandingSpotMemoHits);
+				return Memo;
+			}
+		}
+	}
+	else
+	{
+		// Outside of a falling iteration, nothing is reused
+		LandingSpotMemo.Reset();
+	}
+
+	FPBLandingSpotMemo& Memo = LandingSpotMemo.AddDefaulted_GetRef();
+	Memo.Set(CapsuleLocation, Hit);
+
+	// Landing on a moving base from where we last found its floor finds the same floor, wherever the base has taken us
+	const UPrimitiveComponent* HitComponent = Hit.GetComponent();
+	FTransform BaseTransform;
+	const bool bMovingBase = !Hit.bStartPenetrating && GetMovingBaseTransform(HitComponent, Hit.BoneName, BaseTransform);
+	if (bMovingBase)
+	{
+		const FVector RelativeLocation = BaseTransform.InverseTransformPositionNoScale(CapsuleLocation);
+		if (!BasedFloorCache.Matches(HitComponent, Hit.BoneName, RelativeLocation, BasedFloorTolerance))
+		{
+			BasedFloorCache.Reset(HitComponent, Hit.BoneName, RelativeLocation);
+		}
+		else if (BasedFloorCache.bHasFloor)
+		{
+			BasedFloorCache.GetFloor(BaseTransform, Memo.FloorResult);
+			// The base may have tilted since
+			Memo.FloorResult.bWalkableFloor = Memo.FloorResult.bWalkableFloor && IsWalkable(Memo.FloorResult.HitResult);
+			INC_DWORD_STAT(STAT_PBBasedFloorReuses);
+			return Memo;
+		}
+		INC_DWORD_STAT(STAT_PBBasedFloorQueries);
+	}
+
+	FindFloor(CapsuleLocation, Memo.FloorResult, false, &Hit);
+	INC_DWORD_STAT(STAT_PBFallingFindFloorCalls);
+	if (bMovingBase)
+	{
+		BasedFloorCache.SetFloor(Memo.FloorResult, BaseTransform);
+	}
+	return Memo;
+}
+
+bool UPBPlayerMovement::GetMovingBaseTransform(const UPrimitiveComponent* Base, FName BoneName, FTransform& OutTransform)
+{
+	FVector BaseLocation;
+	FQuat BaseQuat;
+	if (!MovementBaseUtility::UseRelativeLocation(Base) || !MovementBaseUtility::GetMovementBaseTransform(Base, BoneName, BaseLocation, BaseQuat))
+	{
+		return false;
+	}
+	OutTransform = FTransform(BaseQuat, BaseLocation);
+	return true;
+}
+
+bool UPBPlayerMovement::FPBBasedFloorCache::Matches(const UPrimitiveComponent* InBase, FName InBoneName, const FVector& InRelativeLocation, float Tolerance) const
+{
+	return Base.Get() == InBase && BoneName == InBoneName && FVector::DistSquared(RelativeLocation, InRelativeLocation) <= FMath::Square(Tolerance);
+}
+
+void UPBPlayerMovement::FPBBasedFloorCache::Reset(const UPrimitiveComponent* InBase, FName InBoneName, const FVector& InRelativeLocation)
+{
+	Base = InBase;
+	BoneName = InBoneName;
+	RelativeLocation = InRelativeLocation;
+	bHasFloor = false;
+	bHasSurface = false;
+}
+
+void UPBPlayerMovement::FPBBasedFloorCache::SetFloor(const FFindFloorResult& Floor, const FTransform& BaseTransform)
+{
+	// A floor on something else doesn't have to move with the base
+	if (Floor.bBlockingHit && Floor.HitResult.GetComponent() != Base.Get())
+	{
+		bHasFloor = false;
+		return;
+	}
+
+	RelativeFloor = Floor;
+	FHitResult& Hit = RelativeFloor.HitResult;
+	Hit.Location = BaseTransform.InverseTransformPositionNoScale(Hit.Location);
+	Hit.ImpactPoint = BaseTransform.InverseTransformPositionNoScale(Hit.ImpactPoint);
+	Hit.TraceStart = BaseTransform.InverseTransformPositionNoScale(Hit.TraceStart);
+	Hit.TraceEnd = BaseTransform.InverseTransformPositionNoScale(Hit.TraceEnd);
+	Hit.Normal = BaseTransform.InverseTransformVectorNoScale(Hit.Normal);
+	Hit.ImpactNormal = BaseTransform.InverseTransformVectorNoScale(Hit.ImpactNormal);
+	bHasFloor = true;
+}
+
+void UPBPlayerMovement::FPBBasedFloorCache::GetFloor(const FTransform& BaseTransform, FFindFloorResult& OutFloor) const
+{
+	OutFloor = RelativeFloor;
+	FHitResult& Hit = OutFloor.HitResult;
+	Hit.Location = BaseTransform.TransformPositionNoScale(Hit.Location);
+	Hit.ImpactPoint = BaseTransform.TransformPositionNoScale(Hit.ImpactPoint);
+	Hit.TraceStart = BaseTransform.TransformPositionNoScale(Hit.TraceStart);
+	Hit.TraceEnd = BaseTransform.TransformPositionNoScale(Hit.TraceEnd);
+	Hit.Normal = BaseTransform.TransformVectorNoScale(Hit.Normal);
+	Hit.ImpactNormal = BaseTransform.TransformVectorNoScale(Hit.ImpactNormal);
+}
+
 void UPBPlayerMovement::TraceCharacterFloor(FHitResult& OutHit)
 {
-	FCollisionQueryParams CapsuleParams(SCENE_QUERY_STAT(CharacterFloorTrace), false, CharacterOwner);
-	FCollisionResponseParams ResponseParam;
-	InitCollisionParams(CapsuleParams, ResponseParam);
-	// must trace complex to get mesh phys materials
-	CapsuleParams.bTraceComplex = true;
-	// must get materials
-	CapsuleParams.bReturnPhysicalMaterial = true;
+	const FPBQueryParams& Params = GetQueryParams(EPBQueryParams::FloorComplex);
 
 	const FCollisionShape StandingCapsuleShape = GetPawnCapsuleCollisionShape(SHRINK_None);
 	const ECollisionChannel CollisionChannel = UpdatedComponent->GetCollisionObjectType();
@@ -427,13 +1009,70 @@ void UPBPlayerMovement::TraceCharacterFloor(FHitResult& OutHit)
 		FQuat::Identity,
 		CollisionChannel,
 		StandingCapsuleShape,
-		CapsuleParams,
-		ResponseParam
+		Params.QueryParams,
+		Params.ResponseParams
 	);
 }
 
+FPBFloorSurface UPBPlayerMovement::GetFloorSurface()
+{
+	FPBFloorSurface Surface;
+
+	// Most floors have one physical material throughout, so the floor we already found tells us the surface
+	UPBFloorSurfaceSubsystem* FloorSurfaces = UWorld::GetSubsystem<UPBFloorSurfaceSubsystem>(GetWorld());
+	if (FloorSurfaces && CurrentFloor.IsWalkableFloor() && FloorSurfaces->FindSurface(CurrentFloor.HitResult.GetComponent(), Surface))
+	{
+		return Surface;
+	}
+
+	// On a moving base, the face under us only changes when we move on the base
+	const UPrimitiveComponent* FloorComponent = CurrentFloor.HitResult.GetComponent();
+	const FName FloorBoneName = CurrentFloor.HitResult.BoneName;
+	FTransform BaseTransform;
+	const bool bMovingBase = CurrentFloor.IsWalkableFloor() && GetMovingBaseTransform(FloorComponent, FloorBoneName, BaseTransform);
+	if (bMovingBase)
+	{
+		const FVector RelativeLocation = BaseTransform.InverseTransformPositionNoScale(UpdatedComponent->GetComponentLocation());
+		if (!BasedFloorCache.Matches(FloorComponent, FloorBoneName, RelativeLocation, BasedFloorTolerance))
+		{
+			BasedFloorCache.Reset(FloorComponent, FloorBoneName, RelativeLocation);
+		}
+		else if (BasedFloorCache.bHasSurface)
+		{
+			INC_DWORD_STAT(STAT_PBBasedFloorReuses);
+			return BasedFloorCache.Surface;
+		}
+		INC_DWORD_STAT(STAT_PBBasedFloorQueries);
+		// Our floor doubles as the landing floor if we jump and come back down here
+		if (!BasedFloorCache.bHasFloor)
+		{
+			BasedFloorCache.SetFloor(CurrentFloor, BaseTransform);
+		}
+	}
+
+	FHitResult Hit;
+	TraceCharacterFloor(Hit);
+	Surface.Friction = GetFrictionFromHit(Hit);
+	if (Hit.PhysMaterial.IsValid())
+	{
+		Surface.SurfaceType = Hit.PhysMaterial->SurfaceType;
+	}
+	if (bMovingBase)
+	{
+		BasedFloorCache.Surface = Surface;
+		BasedFloorCache.bHasSurface = true;
+	}
+	return Surface;
+}
+
 void UPBPlayerMovement::OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode)
 {
+	bOnLadder = MovementMode == MOVE_Custom && CustomMovementMode == (uint8)EPBCustomMovementMode::Ladder;
+	if (!bOnLadder)
+	{
+		CurrentLadder.Reset();
+	}
+
 	// Reset step side if we are changing modes
 	StepSide = false;
 
@@ -452,26 +1091,6 @@ void UPBPlayerMovement::OnMovementModeChanged(EMovementMode PreviousMovementMode
 	Super::OnMovementModeChanged(PreviousMovementMode, PreviousCustomMode);
 }
 
-float UPBPlayerMovement::GetCameraRoll()
-{
-	if (RollSpeed == 0.0f || RollAngle == 0.0f)
-	{
-		return 0.0f;
-	}
-	float Side = Velocity | FRotationMatrix(GetCharacterOwner()->GetControlRotation()).GetScaledAxis(EAxis::Y);
-	const float Sign = FMath::Sign(Side);
-	Side = FMath::Abs(Side);
-	if (Side < RollSpeed)
-	{
-		Side = Side * RollAngle / RollSpeed;
-	}
-	else
-	{
-		Side = RollAngle;
-	}
-	return Side * Sign;
-}
-
 void UPBPlayerMovement::SetNoClip(bool bNoClip)
 {
 	// We need to defer movement in case we set this outside of main game thread loop, since character movement resets movement back in tick.
@@ -489,23 +1108,108 @@ void UPBPlayerMovement::SetNoClip(bool bNoClip)
 		bCheatFlying = false;
 		GetCharacterOwner()->SetActorEnableCollision(true);
 	}
-	bHasDeferredMovementMode = true;
+	bHasDeferredMovementMode = true;
+}
+
+void UPBPlayerMovement::ToggleNoClip()
+{
+	SetNoClip(!bCheatFlying);
+}
+
+void UPBPlayerMovement::ApplyVelocityBraking(float DeltaTime, float Friction, float BrakingDeceleration)
+{
+	if (!HasValidData() || HasAnimRootMotion())
+	{
+		return;
+	}
+	Velocity = ComputeBrakedVelocity(Velocity, DeltaTime, Friction, BrakingDeceleration);
 }
 
-void UPBPlayerMovement::ToggleNoClip()
+void UPBPlayerMovement::ApplyImpactPhysicsForces(const FHitResult& Impact, const FVector& ImpactAcceleration, const FVector& ImpactVelocity)
 {
-	SetNoClip(!bCheatFlying);
+	// Pawns off the aggregated tick have nothing to flush their pushes before physics
+	UPBMovementTickSubsystem* TickSubsystem = bIsAggregatedTicking ? UWorld::GetSubsystem<UPBMovementTickSubsystem>(GetWorld()) : nullptr;
+	if (!TickSubsystem)
+	{
+		Super::ApplyImpactPhysicsForces(Impact, ImpactAcceleration, ImpactVelocity);
+		return;
+	}
+
+	// UE4-COPY: void UCharacterMovementComponent::ApplyImpactPhysicsForces(const FHitResult& Impact, const FVector& ImpactAcceleration, const FVector& ImpactVelocity)
+	if (bEnablePhysicsInteraction && Impact.bBlockingHit)
+	{
+		if (UPrimitiveComponent* ImpactComponent = Impact.GetComponent())
+		{
+			FBodyInstance* BI = ImpactComponent->GetBodyInstance(Impact.BoneName);
+			if (BI != nullptr && BI->IsInstanceSimulatingPhysics())
+			{
+				FVector ForcePoint = Impact.ImpactPoint;
+
+				const float BodyMass = FMath::Max(BI->GetBodyMass(), 1.0f);
+
+				if (bPushForceUsingZOffset)
+				{
+					FBox Bounds = BI->GetBodyBounds();
+
+					FVector Center, Extents;
+					Bounds.GetCenterAndExtents(Center, Extents);
+
+					if (!Extents.IsNearlyZero())
+					{
+						ForcePoint.Z = Center.Z + Extents.Z * PushForcePointZOffsetFactor;
+					}
+				}
+
+				FVector Force = Impact.ImpactNormal * -1.0f;
+
+				float PushForceModificator = 1.0f;
+
+				const FVector ComponentVelocity = ImpactComponent->GetPhysicsLinearVelocity();
+				const FVector VirtualVelocity = ImpactAcceleration.IsZero() ? ImpactVelocity : ImpactAcceleration.GetSafeNormal() * GetMaxSpeed();
+
+				float Dot = 0.0f;
+
+				if (bScalePushForceToVelocity && !ComponentVelocity.IsNearlyZero())
+				{
+					Dot = ComponentVelocity | VirtualVelocity;
+
+					if (Dot > 0.0f && Dot < 1.0f)
+					{
+						PushForceModificator *= Dot;
+					}
+				}
+
+				if (bPushForceScaledToMass)
+				{
+					PushForceModificator *= BodyMass;
+				}
+
+				Force *= PushForceModificator;
+
+				if (ComponentVelocity.IsNearlyZero())
+				{
+					Force *= InitialPushForceFactor;
+					TickSubsystem->QueuePush(ImpactComponent, Impact.BoneName, Force, ForcePoint, true);
+				}
+				else
+				{
+					Force *= PushForceFactor;
+					TickSubsystem->QueuePush(ImpactComponent, Impact.BoneName, Force, ForcePoint, false);
+				}
+			}
+		}
+	}
 }
 
-void UPBPlayerMovement::ApplyVelocityBraking(float DeltaTime, float Friction, float BrakingDeceleration)
+FVector UPBPlayerMovement::ComputeBrakedVelocity(const FVector& InVelocity, float DeltaTime, float Friction, float BrakingDeceleration) const
 {
 	// UE4-COPY: void UCharacterMovementComponent::ApplyVelocityBraking(float DeltaTime, float Friction, float BrakingDeceleration)
-	if (Velocity.IsNearlyZero(0.1f) || !HasValidData() || HasAnimRootMotion() || DeltaTime < MIN_TICK_TIME)
+	if (InVelocity.IsNearlyZero(0.1f) || DeltaTime < MIN_TICK_TIME)
 	{
-		return;
+		return InVelocity;
 	}
 
-	const float Speed = Velocity.Size2D();
+	const float Speed = InVelocity.Size2D();
 
 	const float FrictionFactor = FMath::Max(0.0f, BrakingFrictionFactor);
 	Friction = FMath::Max(0.0f, Friction * FrictionFactor);
@@ -518,10 +1222,10 @@ void UPBPlayerMovement::ApplyVelocityBraking(float DeltaTime, float Friction, fl
 
 	if (bZeroFriction || bZeroBraking)
 	{
-		return;
+		return InVelocity;
 	}
 
-	const FVector OldVel = Velocity;
+	FVector NewVelocity = InVelocity;
 
 	// subdivide braking to get reasonably consistent results at lower frame rates
 	// (important for packet loss situations w/ networking)
@@ -529,27 +1233,219 @@ void UPBPlayerMovement::ApplyVelocityBraking(float DeltaTime, float Friction, fl
 	const float MaxTimeStep = FMath::Clamp(BrakingSubStepTime, 1.0f / 75.0f, 1.0f / 20.0f);
 
 	// Decelerate to brake to a stop
-	const FVector RevAccel = -Velocity.GetSafeNormal();
+	const FVector RevAccel = -InVelocity.GetSafeNormal();
 	while (RemainingTime >= MIN_TICK_TIME)
 	{
 		const float Delta = (RemainingTime > MaxTimeStep ? FMath::Min(MaxTimeStep, RemainingTime * 0.5f) : RemainingTime);
 		RemainingTime -= Delta;
 
 		// apply friction and braking
-		Velocity += (Friction * BrakingDeceleration * RevAccel) * Delta;
+		NewVelocity += (Friction * BrakingDeceleration * RevAccel) * Delta;
 
 		// Don't reverse direction
-		if ((Velocity | OldVel) <= 0.0f)
+		if ((NewVelocity | InVelocity) <= 0.0f)
 		{
-			Velocity = FVector::ZeroVector;
-			return;
+			return FVector::ZeroVector;
 		}
 	}
 
 	// Clamp to zero if nearly zero
-	if (Velocity.IsNearlyZero(KINDA_SMALL_NUMBER))
+	if (NewVelocity.IsNearlyZero(KINDA_SMALL_NUMBER))
+	{
+		return FVector::ZeroVector;
+	}
+	return NewVelocity;
+}
+
+FVector UPBPlayerMovement::ComputeGroundFrictionVelocity(const FVector& InVelocity, const FVector& InAcceleration, float MaxSpeed, float Friction, float BrakingDeceleration, float InSurfaceFriction, float DeltaTime) const
+{
+	const bool bVelocityOverMax = InVelocity.SizeSquared() > FMath::Square(FMath::Max(0.0f, MaxSpeed)) * 1.01f;
+
+	const float ActualBrakingFriction = (bUseSeparateBrakingFriction ? BrakingFriction : Friction) * InSurfaceFriction;
+	const FVector NewVelocity = ComputeBrakedVelocity(InVelocity, DeltaTime, ActualBrakingFriction, BrakingDeceleration);
+
+	// Don't allow braking to lower us below max speed if we started above it.
+	if (bVelocityOverMax && NewVelocity.SizeSquared() < FMath::Square(MaxSpeed) && FVector::DotProduct(InAcceleration, InVelocity) > 0.0f)
+	{
+		return InVelocity.GetSafeNormal() * MaxSpeed;
+	}
+	return NewVelocity;
+}
+
+FVector UPBPlayerMovement::ComputeInputVelocity(const FVector& InVelocity, const FVector& InAcceleration, float MaxSpeed, bool bGroundMove, float InSurfaceFriction, float DeltaTime) const
+{
+	if (InAcceleration.IsNearlyZero())
+	{
+		return InVelocity;
+	}
+
+	// Clamp acceleration to max speed
+	const FVector ClampedAcceleration = InAcceleration.GetClampedToMaxSize2D(MaxSpeed);
+	// Find veer
+	const FVector AccelDir = ClampedAcceleration.GetSafeNormal2D();
+	const float Veer = InVelocity.X * AccelDir.X + InVelocity.Y * AccelDir.Y;
+	// Get add speed with air speed cap
+	const float AddSpeed = (bGroundMove ? ClampedAcceleration : ClampedAcceleration.GetClampedToMaxSize2D(AirSpeedCap)).Size2D() - Veer;
+	if (AddSpeed <= 0.0f)
+	{
+		return InVelocity;
+	}
+	// Apply acceleration
+	const float AccelerationMultiplier = bGroundMove ? GroundAccelerationMultiplier : AirAccelerationMultiplier;
+	FVector CurrentAcceleration = ClampedAcceleration * AccelerationMultiplier * InSurfaceFriction * DeltaTime;
+	CurrentAcceleration = CurrentAcceleration.GetClampedToMaxSize2D(AddSpeed);
+	return InVelocity + CurrentAcceleration;
+}
+
+const FPBJumpReachability& UPBPlayerMovement::GetJumpReachability() const
+{
+	const uint32 TuningHash = FPBJumpReachability::GetTuningHash(*this);
+	if (!JumpReachability.IsValid() || JumpReachability->TuningHash != TuningHash)
+	{
+		// Shared by tuning within the world, so bots sharing a pawn class only generate them once
+		if (UPBJumpReachabilitySubsystem* ReachabilitySubsystem = UWorld::GetSubsystem<UPBJumpReachabilitySubsystem>(GetWorld()))
+		{
+			JumpReachability = ReachabilitySubsystem->FindOrGenerate(*this, TuningHash);
+		}
+		else
+		{
+			JumpReachability = FPBJumpReachability::Generate(*this);
+		}
+	}
+	return *JumpReachability;
+}
+
+void UPBPlayerMovement::PredictTrajectory(const FPBTrajectoryState& StartState, TArrayView<const FPBTrajectoryInput> InputSequence, int32 NumTicks, const FPBTrajectoryParams& Params, TArray<FPBTrajectoryState>& OutStates) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_PBPredictTrajectory);
+
+	OutStates.Reset(FMath::Max(NumTicks, 0));
+	if (NumTicks <= 0 || Params.TimeStep < MIN_TICK_TIME || !HasValidData())
+	{
+		return;
+	}
+
+	const float TimeStep = Params.TimeStep;
+	const float MaxSpeed = Params.MaxSpeed > 0.0f ? Params.MaxSpeed : GetMaxSpeed();
+	const float MaxDecel = GetMaxBrakingDeceleration();
+	const FVector Gravity(0.0f, 0.0f, GetGravityZ());
+	const bool bSweep = Params.SweepInterval > 0 && GetWorld();
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(PredictTrajectory), false, CharacterOwner);
+	FCollisionResponseParams ResponseParam;
+	FCollisionShape CapsuleShape;
+	ECollisionChannel CollisionChannel = ECC_Pawn;
+	if (bSweep)
+	{
+		InitCollisionParams(QueryParams, ResponseParam);
+		CapsuleShape = GetPawnCapsuleCollisionShape(SHRINK_None);
+		CollisionChannel = UpdatedComponent->GetCollisionObjectType();
+	}
+
+	FPBTrajectoryState State = StartState;
+	FVector LastSweepLocation = State.Location;
+	for (int32 Tick = 0; Tick < NumTicks; Tick++)
 	{
-		Velocity = FVector::ZeroVector;
+		// Hold the last input once the sequence runs out
+		const FPBTrajectoryInput Input = InputSequence.Num() > 0 ? InputSequence[FMath::Min(Tick, InputSequence.Num() - 1)] : FPBTrajectoryInput();
+		const FVector InputAcceleration = FVector(Input.Acceleration.X, Input.Acceleration.Y, 0.0f);
+
+		if (Input.bJump && State.bOnGround)
+		{
+			State.Velocity.Z = State.Velocity.Z <= 0.0f ? JumpZVelocity : State.Velocity.Z + JumpZVelocity;
+			if (Params.bApplyJumpBoost && PBCharacter)
+			{
+				const FVector Facing = FRotator(0.0f, Input.Yaw, 0.0f).Vector();
+				State.Velocity = PBCharacter->ComputeJumpBoostedVelocity(State.Velocity, InputAcceleration.GetClampedToMaxSize2D(MaxSpeed), Facing, MaxSpeed, Params.bReducedJumpBoost);
+			}
+			State.bOnGround = false;
+		}
+
+		// Same braking window as TickComponent, friction only kicks in after we've stayed on the ground
+		const bool bGroundMove = State.bOnGround && State.bBrakingWindowElapsed;
+		const FVector OldVelocity = State.Velocity;
+		FVector NewVelocity = FVector(State.Velocity.X, State.Velocity.Y, 0.0f);
+		if (bGroundMove)
+		{
+			NewVelocity = ComputeGroundFrictionVelocity(NewVelocity, InputAcceleration, MaxSpeed, GroundFriction, MaxDecel, State.SurfaceFriction, TimeStep);
+		}
+		NewVelocity.X = FMath::Clamp(NewVelocity.X, -AxisSpeedLimit, AxisSpeedLimit);
+		NewVelocity.Y = FMath::Clamp(NewVelocity.Y, -AxisSpeedLimit, AxisSpeedLimit);
+		NewVelocity = ComputeInputVelocity(NewVelocity, InputAcceleration, MaxSpeed, bGroundMove, State.bOnGround ? State.SurfaceFriction : 1.0f, TimeStep);
+		NewVelocity.X = FMath::Clamp(NewVelocity.X, -AxisSpeedLimit, AxisSpeedLimit);
+		NewVelocity.Y = FMath::Clamp(NewVelocity.Y, -AxisSpeedLimit, AxisSpeedLimit);
+
+		if (State.bOnGround)
+		{
+			State.Velocity = NewVelocity;
+			State.Location += State.Velocity * TimeStep;
+		}
+		else
+		{
+			NewVelocity.Z = OldVelocity.Z;
+			State.Velocity = NewFallVelocity(NewVelocity, Gravity, TimeStep);
+			// Midpoint integration, like PhysFalling
+			State.Location += 0.5f * (OldVelocity + State.Velocity) * TimeStep;
+		}
+
+		if (State.bOnGround)
+		{
+			State.BrakingWindowTimeElapsed += TimeStep * 1000.0f;
+			State.bBrakingWindowElapsed |= State.BrakingWindowTimeElapsed >= BrakingWindow;
+		}
+		else
+		{
+			State.bBrakingWindowElapsed = false;
+			State.BrakingWindowTimeElapsed = 0.0f;
+		}
+
+		// Cheap collision, one sweep over the path since the last one
+		if (bSweep && ((Tick + 1) % Params.SweepInterval == 0 || Tick == NumTicks - 1))
+		{
+			FHitResult Hit;
+			if (GetWorld()->SweepSingleByChannel(Hit, LastSweepLocation, State.Location, FQuat::Identity, CollisionChannel, CapsuleShape, QueryParams, ResponseParam) && !Hit.bStartPenetrating)
+			{
+				State.Location = Hit.Location;
+				if (!State.bOnGround && State.Velocity.Z <= 0.0f && IsWalkable(Hit))
+				{
+					State.bOnGround = true;
+					State.Velocity.Z = 0.0f;
+					State.SurfaceFriction = GetFrictionFromHit(Hit);
+				}
+				else
+				{
+					State.Velocity = FVector::VectorPlaneProject(State.Velocity, Hit.Normal);
+				}
+				State.bBlocked = true;
+			}
+
+			// Walking off a ledge, nothing to stand on within a step below
+			if (State.bOnGround)
+			{
+				const FVector FloorProbeStart = State.Location + FVector(0.0f, 0.0f, MAX_FLOOR_DIST);
+				const FVector FloorProbeEnd = State.Location - FVector(0.0f, 0.0f, MaxStepHeight + MAX_FLOOR_DIST);
+				FHitResult FloorHit;
+				const bool bFloorHit = GetWorld()->SweepSingleByChannel(FloorHit, FloorProbeStart, FloorProbeEnd, FQuat::Identity, CollisionChannel, CapsuleShape, QueryParams, ResponseParam);
+				if (bFloorHit && FloorHit.bStartPenetrating)
+				{
+					// Wedged in something, keep the ground
+				}
+				else if (bFloorHit && IsWalkable(FloorHit))
+				{
+					// Follow the ground down steps and slopes
+					State.Location.Z = FMath::Min(State.Location.Z, FloorHit.Location.Z);
+					State.SurfaceFriction = GetFrictionFromHit(FloorHit);
+				}
+				else
+				{
+					State.bOnGround = false;
+				}
+			}
+			LastSweepLocation = State.Location;
+		}
+
+		OutStates.Add(State);
+		State.bBlocked = false;
 	}
 }
 
@@ -569,6 +1465,7 @@ void UPBPlayerMovement::UpdateCharacterStateBeforeMovement(float DeltaSeconds)
 {
 	Super::UpdateCharacterStateBeforeMovement(DeltaSeconds);
 	Velocity.Z = FMath::Clamp(Velocity.Z, -AxisSpeedLimit, AxisSpeedLimit);
+	UpdateLadderState(DeltaSeconds);
 	UpdateCrouching(DeltaSeconds);
 
 }
@@ -581,13 +1478,25 @@ void UPBPlayerMovement::UpdateCharacterStateAfterMovement(float DeltaSeconds)
 	UpdateCrouching(DeltaSeconds, true);
 }
 
+void UPBPlayerMovement::UpdateBasedMovement(float DeltaSeconds)
+{
+	if (!MovementBaseUtility::UseRelativeLocation(CharacterOwner ? CharacterOwner->GetMovementBase() : nullptr))
+	{
+		Super::UpdateBasedMovement(DeltaSeconds);
+		return;
+	}
+
+	// Divided by the based pawn count, this is the cost of each pawn riding a moving platform
+	SCOPE_CYCLE_COUNTER(STAT_PBBasedMovement);
+	INC_DWORD_STAT(STAT_PBBasedPawns);
+	Super::UpdateBasedMovement(DeltaSeconds);
+}
+
 void UPBPlayerMovement::UpdateSurfaceFriction(bool bIsSliding)
 {
 	if (!IsFalling() && CurrentFloor.IsWalkableFloor())
 	{
-		FHitResult Hit;
-		TraceCharacterFloor(Hit);
-		SurfaceFriction = GetFrictionFromHit(Hit);
+		SurfaceFriction = GetFloorSurface().Friction;
 	}
 	else
 	{
@@ -610,6 +1519,11 @@ void UPBPlayerMovement::UpdateCrouching(float DeltaTime, bool bOnlyUncrouch)
 		return;
 	}
 
+	if (IsCrouching() || bIsInCrouchTransition)
+	{
+		INC_DWORD_STAT(STAT_PBCrouchedPawnTicks);
+	}
+
 	// Crouch transition but not in noclip
 	if (bIsInCrouchTransition && !bCheatFlying)
 	{
@@ -620,12 +1534,12 @@ void UPBPlayerMovement::UpdateCrouching(float DeltaTime, bool bOnlyUncrouch)
 				if (IsWalking())
 				{
 					// Normal uncrouch
-					DoUnCrouchResize(UncrouchTime, DeltaTime);
+					DoUnCrouchResize(EPBCrouchTransition::Uncrouch, DeltaTime);
 				}
 				else
 				{
 					// Uncrouch jump
-					DoUnCrouchResize(UncrouchJumpTime, DeltaTime);
+					DoUnCrouchResize(EPBCrouchTransition::UncrouchJump, DeltaTime);
 				}
 			}
 		}
@@ -639,11 +1553,11 @@ void UPBPlayerMovement::UpdateCrouching(float DeltaTime, bool bOnlyUncrouch)
 			{
 				if (IsWalking())
 				{
-					DoCrouchResize(CrouchTime, DeltaTime);
+					DoCrouchResize(EPBCrouchTransition::Crouch, DeltaTime);
 				}
 				else
 				{
-					DoCrouchResize(CrouchJumpTime, DeltaTime);
+					DoCrouchResize(EPBCrouchTransition::CrouchJump, DeltaTime);
 				}
 			}
 		}
@@ -652,37 +1566,59 @@ void UPBPlayerMovement::UpdateCrouching(float DeltaTime, bool bOnlyUncrouch)
 
 UPBMoveStepSound* UPBPlayerMovement::GetMoveStepSoundBySurface(EPhysicalSurface SurfaceType) const
 {
-	TSubclassOf<UPBMoveStepSound>* GotSound = PBCharacter->GetMoveStepSound(TEnumAsByte<EPhysicalSurface>(SurfaceType));
-
-	if (GotSound)
-	{
-		return GotSound->GetDefaultObject();
-	}
-
-	return nullptr;
+	return PBCharacter->GetMoveStepSound(TEnumAsByte<EPhysicalSurface>(SurfaceType));
 }
 
 
-void UPBPlayerMovement::PlayMoveSound(const float DeltaTime)
+bool UPBPlayerMovement::IsMoveSoundAudible() const
 {
-	if (!bShouldPlayMoveSounds)
+	const UWorld* World = GetWorld();
+
+	const UPBNoiseEventSubsystem* NoiseEvents = UWorld::GetSubsystem<UPBNoiseEventSubsystem>(World);
+	if (NoiseEvents && NoiseEvents->HasActiveReaders())
 	{
-		return;
+		return true;
 	}
 
-	// Count move sound time down if we've got it
-	if (MoveSoundTime > 0.0f)
+	// No audio device on a dedicated server, or with audio disabled
+	FAudioDevice* AudioDevice = World->GetAudioDeviceRaw();
+	if (!AudioDevice)
 	{
-		MoveSoundTime = FMath::Max(0.0f, MoveSoundTime - 1000.0f * DeltaTime);
+		return false;
 	}
 
-	// Check if it's time to play the sound
-	if (MoveSoundTime > 0.0f)
+	const UPBMoveStepSoundSubsystem* MoveStepSounds = UWorld::GetSubsystem<UPBMoveStepSoundSubsystem>(World);
+	const float MaxDistance = MoveStepSounds ? MoveStepSounds->GetMaxAudibleDistance() : 0.0f;
+	if (MaxDistance <= 0.0f)
 	{
-		return;
+		// Don't know how far the step sounds carry yet
+		return true;
+	}
+
+	return AudioDevice->LocationIsAudible(CharacterOwner->GetActorLocation(), MaxDistance);
+}
+
+float UPBPlayerMovement::GetStrideLength(EPBStepStride Stride) const
+{
+	switch (Stride)
+	{
+		case EPBStepStride::Walk:
+			return WalkStrideLength;
+		case EPBStepStride::Sprint:
+			return SprintStrideLength;
+		case EPBStepStride::Crouch:
+			return CrouchStrideLength;
+		case EPBStepStride::Ladder:
+			return LadderStrideLength;
+		case EPBStepStride::Run:
+		default:
+			return RunStrideLength;
 	}
+}
 
-	const float Speed = Velocity.SizeSquared();
+void UPBPlayerMovement::UpdateStepCadence(float DeltaTime)
+{
+	const float SpeedSq = Velocity.SizeSquared();
 	float RunSpeedThreshold;
 	float SprintSpeedThreshold;
 
@@ -697,37 +1633,103 @@ void UPBPlayerMovement::PlayMoveSound(const float DeltaTime)
 		SprintSpeedThreshold = SprintSpeed;
 	}
 
-	// Only play sounds if we are moving fast enough on the ground or on a
+	// Only step if we are moving fast enough on the ground or on a
 	// ladder
-	const bool bPlaySound = (bBrakingWindowElapsed || bOnLadder) && Speed >= RunSpeedThreshold * RunSpeedThreshold;
+	if (!(bBrakingWindowElapsed || bOnLadder) || SpeedSq < RunSpeedThreshold * RunSpeedThreshold)
+	{
+		// Step as soon as we get going again
+		StepDistanceRemaining = 0.0f;
+		return;
+	}
 
-	if (!bPlaySound)
+	// Ground steps go by horizontal distance, ladder steps by distance climbed
+	const float StepSpeed = bOnLadder ? FMath::Sqrt(SpeedSq) : Velocity.Size2D();
+	StepDistanceRemaining -= StepSpeed * DeltaTime;
+	if (StepDistanceRemaining > 0.0f)
 	{
 		return;
 	}
 
-	const bool bSprinting = Speed >= SprintSpeedThreshold * SprintSpeedThreshold;
+	INC_DWORD_STAT(STAT_PBSteps);
+
+	FPBStepEvent Step;
+	Step.Speed = FMath::Sqrt(SpeedSq);
+	Step.bSprinting = SpeedSq >= SprintSpeedThreshold * SprintSpeedThreshold;
+	Step.bLeftStep = StepSide;
+	if (bOnLadder)
+	{
+		Step.Stride = EPBStepStride::Ladder;
+	}
+	else if (IsCrouching())
+	{
+		Step.Stride = EPBStepStride::Crouch;
+	}
+	else if (Step.bSprinting)
+	{
+		Step.Stride = EPBStepStride::Sprint;
+	}
+	else
+	{
+		Step.Stride = Step.Speed >= RunSpeed ? EPBStepStride::Run : EPBStepStride::Walk;
+	}
+
+	// The stride was completed part way through the tick, by however far we overshot it
+	const float Overshoot = StepSpeed > KINDA_SMALL_NUMBER ? -StepDistanceRemaining / StepSpeed : 0.0f;
+	Step.Time = GetWorld()->GetTimeSeconds() - Overshoot;
+	Step.Location = CharacterOwner->GetActorLocation() - Velocity * Overshoot - FVector(0.0f, 0.0f, CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleHalfHeight());
+
+	// One step per tick at most, so a hitch doesn't play a burst of steps
+	StepDistanceRemaining += GetStrideLength(Step.Stride);
+	if (StepDistanceRemaining <= 0.0f)
+	{
+		StepDistanceRemaining = GetStrideLength(Step.Stride);
+	}
+	StepSide = !StepSide;
+
+	OnStep.Broadcast(Step);
+	PlayMoveSound(Step);
+}
+
+void UPBPlayerMovement::PlayMoveSound(const FPBStepEvent& Step)
+{
+	if (!bShouldPlayMoveSounds)
+	{
+		return;
+	}
+
+	const bool bSprinting = Step.bSprinting;
+
+	// Nobody could hear this step, so skip the floor trace and sound selection
+	if (!IsMoveSoundAudible())
+	{
+		if (!bOnLadder)
+		{
+			INC_DWORD_STAT(STAT_PBFootstepTracesCulled);
+		}
+		return;
+	}
 
 	float MoveSoundVolume = 0.f;
 
 	UPBMoveStepSound* MoveSound = nullptr;
+	const EPhysicalSurface StepSurface = bOnLadder ? SurfaceType1 : GetFloorSurface().SurfaceType;
+
+	// Published before any asset lookup, the step sounds aren't loaded on dedicated servers
+	float NoiseLoudness = bOnLadder ? 0.5f : (bSprinting ? SprintNoiseLoudness : WalkNoiseLoudness);
+	if (IsCrouching() && !bOnLadder)
+	{
+		NoiseLoudness *= 0.65f;
+	}
+	PublishNoiseEvent(EPBNoiseEventType::Footstep, Step.Location, NoiseLoudness, StepSurface);
 
 	if (bOnLadder)
 	{
 		MoveSoundVolume = 0.5f;
-		MoveSoundTime = 450.0f;
-		MoveSound = GetMoveStepSoundBySurface(SurfaceType1);
+		MoveSound = GetMoveStepSoundBySurface(StepSurface);
 	}
 	else
 	{
-		MoveSoundTime = bSprinting ? 300.0f : 400.0f;
-		FHitResult Hit;
-		TraceCharacterFloor(Hit);
-
-		if (Hit.PhysMaterial.IsValid())
-		{
-			MoveSound = GetMoveStepSoundBySurface(Hit.PhysMaterial->SurfaceType);
-		}
+		MoveSound = GetMoveStepSoundBySurface(StepSurface);
 		if (!MoveSound)
 		{
 			MoveSound = GetMoveStepSoundBySurface(SurfaceType_Default);
@@ -741,26 +1743,25 @@ void UPBPlayerMovement::PlayMoveSound(const float DeltaTime)
 			if (IsCrouching())
 			{
 				MoveSoundVolume *= 0.65f;
-				MoveSoundTime += 100.0f;
 			}
 		}
 	}
 
 	if (MoveSound)
 	{
-		TArray<USoundCue*> MoveSoundCues;
+		const TArray<TSoftObjectPtr<USoundCue>>* MoveSoundCues = nullptr;
 
 		if (bSprinting && !bOnLadder)
 		{
-			MoveSoundCues = StepSide ? MoveSound->GetSprintLeftSounds() : MoveSound->GetSprintRightSounds();
+			MoveSoundCues = Step.bLeftStep ? &MoveSound->GetSprintLeftSounds() : &MoveSound->GetSprintRightSounds();
 		}
-		if (!bSprinting || bOnLadder || MoveSoundCues.Num() < 1)
+		if (!bSprinting || bOnLadder || MoveSoundCues->Num() < 1)
 		{
-			MoveSoundCues = StepSide ? MoveSound->GetStepLeftSounds() : MoveSound->GetStepRightSounds();
+			MoveSoundCues = Step.bLeftStep ? &MoveSound->GetStepLeftSounds() : &MoveSound->GetStepRightSounds();
 		}
 
 		// Error handling - Sounds not valid
-		if (MoveSoundCues.Num() < 1)	// Sounds array not valid
+		if (MoveSoundCues->Num() < 1)	// Sounds array not valid
 		{
 			// Get default sounds
 			MoveSound = GetMoveStepSoundBySurface(SurfaceType_Default);
@@ -773,18 +1774,18 @@ void UPBPlayerMovement::PlayMoveSound(const float DeltaTime)
 			if (bSprinting)
 			{
 				// Get default sprint sounds
-				MoveSoundCues = StepSide ? MoveSound->GetSprintLeftSounds() : MoveSound->GetSprintRightSounds();
+				MoveSoundCues = Step.bLeftStep ? &MoveSound->GetSprintLeftSounds() : &MoveSound->GetSprintRightSounds();
 			}
 
-			if (!bSprinting || MoveSoundCues.Num() < 1)
+			if (!bSprinting || MoveSoundCues->Num() < 1)
 			{
 				// If bSprinting = true, the code enter this IF only if the updated MoveSoundCues with default sprint sounds is not valid (length < 1)
 				// If bSprinting = false, the code enter this IF because the walk sounds are not valid and must try to pick them from the default surface
 				// Get default walk sounds
-				MoveSoundCues = StepSide ? MoveSound->GetStepLeftSounds() : MoveSound->GetStepRightSounds();
+				MoveSoundCues = Step.bLeftStep ? &MoveSound->GetStepLeftSounds() : &MoveSound->GetStepRightSounds();
 			}
 
-			if (MoveSoundCues.Num() < 1)
+			if (MoveSoundCues->Num() < 1)
 			{
 				// SurfaceType_Default sounds not found, return
 				return;
@@ -793,17 +1794,16 @@ void UPBPlayerMovement::PlayMoveSound(const float DeltaTime)
 
 		// Sound array is valid, play a sound
 		// If the array has just one element pick that one skipping random
-		USoundCue* Sound = MoveSoundCues[MoveSoundCues.Num() == 1 ? 0 : FMath::RandRange(0, MoveSoundCues.Num() - 1)];
+		USoundCue* Sound = UPBMoveStepSoundSubsystem::ResolveSound(GetWorld(), (*MoveSoundCues)[MoveSoundCues->Num() == 1 ? 0 : CosmeticRandomStream.RandRange(0, MoveSoundCues->Num() - 1)]);
+		if (!Sound)
+		{
+			return;
+		}
 
 		Sound->VolumeMultiplier = MoveSoundVolume;
 
-		const FVector Location = CharacterOwner->GetActorLocation();
-		const FVector StepLocation(FVector(Location.X, Location.Y, Location.Z - GetCharacterOwner()->GetCapsuleComponent()->GetScaledCapsuleHalfHeight()));
-
-		/*UPBGameplayStatics::SpawnSoundAtLocation(CharacterOwner->GetWorld(), Sound, StepLocation);*/
-		UGameplayStatics::SpawnSoundAtLocation(CharacterOwner->GetWorld(), Sound, StepLocation);
-
-		StepSide = !StepSide;
+		/*UPBGameplayStatics::SpawnSoundAtLocation(CharacterOwner->GetWorld(), Sound, Step.Location);*/
+		UGameplayStatics::SpawnSoundAtLocation(CharacterOwner->GetWorld(), Sound, Step.Location);
 	}
 }
 
@@ -814,23 +1814,24 @@ void UPBPlayerMovement::PlayJumpSound(const FHitResult& Hit, bool bJumped)
 		return;
 	}
 
-	UPBMoveStepSound* MoveSound = nullptr;
-	TSubclassOf<UPBMoveStepSound>* GotSound = nullptr;
-	if (Hit.PhysMaterial.IsValid())
+	const FVector Location = CharacterOwner->GetActorLocation();
+	const FVector StepLocation(Location.X, Location.Y, Location.Z - GetCharacterOwner()->GetCapsuleComponent()->GetScaledCapsuleHalfHeight());
+
+	// Published before any asset lookup, the step sounds aren't loaded on dedicated servers
+	const float NoiseLoudness = GetJumpNoiseLoudness(bJumped);
+	if (NoiseLoudness > 0.0f)
 	{
-		GotSound = PBCharacter->GetMoveStepSound(Hit.PhysMaterial->SurfaceType);
+		PublishNoiseEvent(bJumped ? EPBNoiseEventType::Jump : EPBNoiseEventType::Land, StepLocation, NoiseLoudness, Hit.PhysMaterial.IsValid() ? Hit.PhysMaterial->SurfaceType.GetValue() : SurfaceType_Default);
 	}
-	if (GotSound)
+
+	UPBMoveStepSound* MoveSound = nullptr;
+	if (Hit.PhysMaterial.IsValid())
 	{
-		MoveSound = GotSound->GetDefaultObject();
+		MoveSound = GetMoveStepSoundBySurface(Hit.PhysMaterial->SurfaceType);
 	}
 	if (!MoveSound)
 	{
-		if (!PBCharacter->GetMoveStepSound(TEnumAsByte<EPhysicalSurface>(SurfaceType_Default)))
-		{
-			return;
-		}
-		MoveSound = PBCharacter->GetMoveStepSound(TEnumAsByte<EPhysicalSurface>(SurfaceType_Default))->GetDefaultObject();
+		MoveSound = GetMoveStepSoundBySurface(SurfaceType_Default);
 	}
 
 	if (MoveSound)
@@ -840,32 +1841,15 @@ void UPBPlayerMovement::PlayJumpSound(const FHitResult& Hit, bool bJumped)
 		// if we didn't jump, adjust volume for landing
 		if (!bJumped)
 		{
-			const float FallSpeed = -Velocity.Z;
-			if (FallSpeed > PBCharacter->GetMinSpeedForFallDamage())
-			{
-				MoveSoundVolume = 1.0f;
-			}
-			else if (FallSpeed > PBCharacter->GetMinSpeedForFallDamage() / 2.0f)
-			{
-				MoveSoundVolume = 0.85f;
-			}
-			else if (FallSpeed < PBCharacter->GetMinLandBounceSpeed())
-			{
-				MoveSoundVolume = 0.0f;
-			}
-			else
-			{
-				MoveSoundVolume = 0.5f;
-			}
+			MoveSoundVolume = NoiseLoudness;
 		}
 		else
 		{
 			MoveSoundVolume = PBCharacter->IsSprinting() ? MoveSound->GetSprintVolume() : MoveSound->GetWalkVolume();
-		}
-
-		if (IsCrouching())
-		{
-			MoveSoundVolume *= 0.65f;
+			if (IsCrouching())
+			{
+				MoveSoundVolume *= 0.65f;
+			}
 		}
 
 		if (MoveSoundVolume <= 0.0f)
@@ -873,7 +1857,7 @@ void UPBPlayerMovement::PlayJumpSound(const FHitResult& Hit, bool bJumped)
 			return;
 		}
 
-		const TArray<USoundCue*>& MoveSoundCues = bJumped ? MoveSound->GetJumpSounds() : MoveSound->GetLandSounds();
+		const TArray<TSoftObjectPtr<USoundCue>>& MoveSoundCues = bJumped ? MoveSound->GetJumpSounds() : MoveSound->GetLandSounds();
 
 		if (MoveSoundCues.Num() < 1)
 		{
@@ -881,36 +1865,108 @@ void UPBPlayerMovement::PlayJumpSound(const FHitResult& Hit, bool bJumped)
 		}
 
 		// If the array has just one element pick that one skipping random
-		USoundCue* Sound = MoveSoundCues[MoveSoundCues.Num() == 1 ? 0 : FMath::RandRange(0, MoveSoundCues.Num() - 1)];
+		USoundCue* Sound = UPBMoveStepSoundSubsystem::ResolveSound(GetWorld(), MoveSoundCues[MoveSoundCues.Num() == 1 ? 0 : CosmeticRandomStream.RandRange(0, MoveSoundCues.Num() - 1)]);
+		if (!Sound)
+		{
+			return;
+		}
 
 		Sound->VolumeMultiplier = MoveSoundVolume;
-		const FVector Location = CharacterOwner->GetActorLocation();
-		const FVector StepLocation(Location.X, Location.Y, Location.Z - GetCharacterOwner()->GetCapsuleComponent()->GetScaledCapsuleHalfHeight());
 		/*UPBGameplayStatics::SpawnSoundAtLocation(CharacterOwner->GetWorld(), Sound, StepLocation);*/
 		UGameplayStatics::SpawnSoundAtLocation(CharacterOwner->GetWorld(), Sound, StepLocation);
 	}
 }
 
+float UPBPlayerMovement::GetJumpNoiseLoudness(bool bJumped) const
+{
+	float Loudness;
+
+	// if we didn't jump, adjust loudness for landing
+	if (!bJumped)
+	{
+		const float FallSpeed = -Velocity.Z;
+		if (FallSpeed > PBCharacter->GetMinSpeedForFallDamage())
+		{
+			Loudness = 1.0f;
+		}
+		else if (FallSpeed > PBCharacter->GetMinSpeedForFallDamage() / 2.0f)
+		{
+			Loudness = 0.85f;
+		}
+		else if (FallSpeed < PBCharacter->GetMinLandBounceSpeed())
+		{
+			Loudness = 0.0f;
+		}
+		else
+		{
+			Loudness = 0.5f;
+		}
+	}
+	else
+	{
+		Loudness = PBCharacter->IsSprinting() ? SprintNoiseLoudness : WalkNoiseLoudness;
+	}
+
+	if (IsCrouching())
+	{
+		Loudness *= 0.65f;
+	}
+
+	return Loudness;
+}
+
+void UPBPlayerMovement::PublishNoiseEvent(EPBNoiseEventType Type, const FVector& Location, float Loudness, EPhysicalSurface Surface) const
+{
+	UPBNoiseEventSubsystem* NoiseEvents = UWorld::GetSubsystem<UPBNoiseEventSubsystem>(GetWorld());
+	if (!NoiseEvents)
+	{
+		return;
+	}
+
+	FPBNoiseEvent Event;
+	Event.Location = Location;
+	Event.Loudness = Loudness;
+	Event.Time = GetWorld()->GetTimeSeconds();
+	Event.Instigator = CharacterOwner;
+	Event.Surface = Surface;
+	Event.Type = Type;
+	NoiseEvents->Publish(Event);
+}
+
 void UPBPlayerMovement::PhysFalling(float deltaTime, int32 Iterations)
 {
 	SCOPE_CYCLE_COUNTER(STAT_CharPhysFalling);
 	CSV_SCOPED_TIMING_STAT_EXCLUSIVE(CharPhysFalling);
+	INC_DWORD_STAT(STAT_PBPhysFallingTicks);
 
 	if (deltaTime < MIN_TICK_TIME)
 	{
 		return;
 	}
 
+	TGuardValue<bool> LandingSpotMemoGuard(bLandingSpotMemoActive, true);
+
 	FVector FallAcceleration = GetFallingLateralAcceleration(deltaTime);
 	FallAcceleration.Z = 0.f;
 	const bool bHasLimitedAirControl = ShouldLimitAirControl(deltaTime, FallAcceleration);
 
+	// Only fast moves get split up, slow pawns keep a single iteration
+	const int32 Substeps = GetAdaptiveAirSubsteps(deltaTime);
+	const int32 MaxIterations = Substeps > 1 ? FMath::Max(MaxSimulationIterations, Iterations + Substeps) : MaxSimulationIterations;
+	if (Substeps > 1)
+	{
+		INC_DWORD_STAT_BY(STAT_PBAdaptiveAirSubsteps, Substeps);
+	}
+
 	float remainingTime = deltaTime;
-	while( (remainingTime >= MIN_TICK_TIME) && (Iterations < MaxSimulationIterations) )
+	while( (remainingTime >= MIN_TICK_TIME) && (Iterations < MaxIterations) )
 	{
 		Iterations++;
-		float timeTick = GetSimulationTimeStep(remainingTime, Iterations);
+		// Spread what is left evenly over the remaining substeps
+		float timeTick = Substeps > 1 ? remainingTime / (MaxIterations - Iterations + 1) : GetSimulationTimeStep(remainingTime, Iterations);
 		remainingTime -= timeTick;
+		// Landing spots are only reused within one iteration, we move in between
+		LandingSpotMemo.Reset();
 		
 		const FVector OldLocation = UpdatedComponent->GetComponentLocation();
 		const FQuat PawnRotation = UpdatedComponent->GetComponentQuat();
@@ -1015,6 +2071,11 @@ void UPBPlayerMovement::PhysFalling(float deltaTime, int32 Iterations)
 		{
 			return;
 		}
+
+		if (Hit.bStartPenetrating)
+		{
+			INC_DWORD_STAT(STAT_PBFallingPenetrations);
+		}
 		
 		float LastMoveTimeSlice = timeTick;
 		float subTimeTickRemaining = timeTick * (1.f - Hit.Time);
@@ -1046,6 +2107,11 @@ void UPBPlayerMovement::PhysFalling(float deltaTime, int32 Iterations)
 					const FVector PawnLocation = UpdatedComponent->GetComponentLocation();
 					FFindFloorResult FloorResult;
 					FindFloor(PawnLocation, FloorResult, false);
+					INC_DWORD_STAT(STAT_PBFallingFindFloorCalls);
+					// Validating this floor hit from here would find the same floor again
+					FPBLandingSpotMemo& Memo = LandingSpotMemo.AddDefaulted_GetRef();
+					Memo.Set(PawnLocation, FloorResult.HitResult);
+					Memo.FloorResult = FloorResult;
 					if (FloorResult.IsWalkableFloor() && IsValidLandingSpot(PawnLocation, FloorResult.HitResult))
 					{
 						remainingTime += subTimeTickRemaining;
@@ -1182,8 +2248,8 @@ void UPBPlayerMovement::PhysFalling(float deltaTime, int32 Iterations)
 							const float MovedDist2DSq = (PawnLocation - OldLocation).SizeSquared2D();
 							if (ZMovedDist <= 0.2f * timeTick && MovedDist2DSq <= 4.f * timeTick)
 							{
-								Velocity.X += 0.25f * GetMaxSpeed() * (RandomStream.FRand() - 0.5f);
-								Velocity.Y += 0.25f * GetMaxSpeed() * (RandomStream.FRand() - 0.5f);
+								Velocity.X += 0.25f * GetMaxSpeed() * (MoveRandomStream.FRand() - 0.5f);
+								Velocity.Y += 0.25f * GetMaxSpeed() * (MoveRandomStream.FRand() - 0.5f);
 								Velocity.Z = FMath::Max<float>(JumpZVelocity * 0.25f, 1.f);
 								Delta = Velocity * timeTick;
 								SafeMoveUpdatedComponent(Delta, PawnRotation, true, Hit);
@@ -1202,6 +2268,133 @@ void UPBPlayerMovement::PhysFalling(float deltaTime, int32 Iterations)
 	}
 }
 
+int32 UPBPlayerMovement::GetAdaptiveAirSubsteps(float DeltaTime) const
+{
+	if (!bUseAdaptiveAirSubstepping || MaxAdaptiveSubsteps <= 1 || !CharacterOwner)
+	{
+		return 1;
+	}
+
+	// Estimate how far we go this tick, including what gravity adds
+	const FVector EndVelocity = Velocity + FVector(0.0f, 0.0f, GetGravityZ() * DeltaTime);
+	const float Displacement = FMath::Max(Velocity.Size(), EndVelocity.Size()) * DeltaTime;
+	const float MaxStepDistance = CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleRadius() * AdaptiveSubstepRadiusFraction;
+	if (MaxStepDistance <= KINDA_SMALL_NUMBER || Displacement <= MaxStepDistance)
+	{
+		return 1;
+	}
+	return FMath::Clamp(FMath::CeilToInt(Displacement / MaxStepDistance), 1, MaxAdaptiveSubsteps);
+}
+
+void UPBPlayerMovement::PhysCustom(float deltaTime, int32 Iterations)
+{
+	if (CustomMovementMode == (uint8)EPBCustomMovementMode::Ladder)
+	{
+		PhysLadder(deltaTime, Iterations);
+		return;
+	}
+
+	Super::PhysCustom(deltaTime, Iterations);
+}
+
+void UPBPlayerMovement::PhysLadder(float deltaTime, int32 Iterations)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PBPhysLadder);
+
+	if (deltaTime < MIN_TICK_TIME)
+	{
+		return;
+	}
+
+	if (!CurrentLadder.IsValid())
+	{
+		SetMovementMode(MOVE_Falling);
+		StartNewPhysics(deltaTime, Iterations);
+		return;
+	}
+
+	RestorePreAdditiveRootMotionVelocity();
+
+	if (!HasAnimRootMotion() && !CurrentRootMotion.HasOverrideVelocity())
+	{
+		CalcVelocity(deltaTime, GroundFriction, false, GetMaxBrakingDeceleration());
+	}
+
+	ApplyRootMotionToVelocity(deltaTime);
+
+	Iterations++;
+	bJustTeleported = false;
+
+	const FVector OldLocation = UpdatedComponent->GetComponentLocation();
+	const FVector Delta = Velocity * deltaTime;
+	FHitResult Hit(1.0f);
+	SafeMoveUpdatedComponent(Delta, UpdatedComponent->GetComponentQuat(), true, Hit);
+
+	if (Hit.Time < 1.0f)
+	{
+		if (Velocity.Z < 0.0f && IsWalkable(Hit))
+		{
+			// Climbed down onto the floor
+			OffLadderTicks = LADDER_MOUNT_TIMEOUT;
+			SetMovementMode(MOVE_Walking);
+			StartNewPhysics(deltaTime * (1.0f - Hit.Time), Iterations);
+			return;
+		}
+
+		HandleImpact(Hit, deltaTime, Delta);
+		SlideAlongSurface(Delta, 1.0f - Hit.Time, Hit.Normal, Hit, true);
+	}
+
+	if (!bJustTeleported && !HasAnimRootMotion() && !CurrentRootMotion.HasOverrideVelocity())
+	{
+		Velocity = (UpdatedComponent->GetComponentLocation() - OldLocation) / deltaTime;
+	}
+}
+
+void UPBPlayerMovement::UpdateLadderState(float DeltaSeconds)
+{
+	if (OffLadderTicks > 0.0f)
+	{
+		OffLadderTicks -= DeltaSeconds;
+	}
+
+	if (!HasValidData() || bCheatFlying || CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy)
+	{
+		return;
+	}
+
+	const UPBLadderSubsystem* LadderSubsystem = UWorld::GetSubsystem<UPBLadderSubsystem>(GetWorld());
+	if (!LadderSubsystem || (!bOnLadder && LadderSubsystem->GetNumLadders() == 0))
+	{
+		return;
+	}
+
+	float PawnRadius, PawnHalfHeight;
+	CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleSize(PawnRadius, PawnHalfHeight);
+	APBLadderVolume* Ladder = LadderSubsystem->FindLadder(UpdatedComponent->GetComponentLocation(), PawnRadius, PawnHalfHeight);
+
+	if (bOnLadder)
+	{
+		if (Ladder)
+		{
+			CurrentLadder = Ladder;
+		}
+		else
+		{
+			// Climbed off the top or side
+			SetMovementMode(MOVE_Falling);
+		}
+		return;
+	}
+
+	// Grab the ladder when pushing into it, unless we just left one
+	if (Ladder && OffLadderTicks <= 0.0f && (Acceleration | Ladder->GetLadderNormal()) < 0.0f)
+	{
+		CurrentLadder = Ladder;
+		SetMovementMode(MOVE_Custom, (uint8)EPBCustomMovementMode::Ladder);
+	}
+}
+
 void UPBPlayerMovement::CalcVelocity(float DeltaTime, float Friction, bool bFluid, float BrakingDeceleration)
 {
 	// UE4-COPY: void UCharacterMovementComponent::CalcVelocity(float DeltaTime, float Friction, bool bFluid, float BrakingDeceleration)
@@ -1216,18 +2409,13 @@ void UPBPlayerMovement::CalcVelocity(float DeltaTime, float Friction, bool bFlui
 	const float MaxAccel = GetMaxAcceleration();
 	float MaxSpeed = GetMaxSpeed();
 
-	// Player doesn't path follow
-#if 0
-	// Check if path following requested movement
-	bool bZeroRequestedAcceleration = true;
-	FVector RequestedAcceleration = FVector::ZeroVector;
+	// Path following (AI) requests a velocity, steer with it as input so it goes through the PB acceleration model
 	float RequestedSpeed = 0.0f;
-	if (ApplyRequestedMove(DeltaTime, MaxAccel, MaxSpeed, Friction, BrakingDeceleration, RequestedAcceleration, RequestedSpeed))
+	if (ApplyRequestedMoveAsInput(MaxAccel, RequestedSpeed))
 	{
-		RequestedAcceleration = RequestedAcceleration.GetClampedToMaxSize(MaxAccel);
-		bZeroRequestedAcceleration = false;
+		// Slow down when asked to, e.g. arriving at the goal
+		MaxSpeed = FMath::Min(MaxSpeed, RequestedSpeed);
 	}
-#endif
 
 	if (bForceMaxAccel)
 	{
@@ -1245,20 +2433,13 @@ void UPBPlayerMovement::CalcVelocity(float DeltaTime, float Friction, bool bFlui
 		AnalogInputModifier = 1.0f;
 	}
 
-#if 0
-	// Path following above didn't care about the analog modifier, but we do for everything else below, so get the fully modified value.
-	// Use max of requested speed and max speed if we modified the speed in ApplyRequestedMove above.
-	const float MaxInputSpeed = FMath::Max(MaxSpeed * AnalogInputModifier, GetMinAnalogSpeed());
-	MaxSpeed = FMath::Max(RequestedSpeed, MaxInputSpeed);
-#else
 	MaxSpeed = FMath::Max(MaxSpeed * AnalogInputModifier, GetMinAnalogSpeed());
-#endif
 
 	// Apply braking or deceleration
 	const bool bZeroAcceleration = Acceleration.IsNearlyZero();
 	const bool bIsGroundMove = IsMovingOnGround() && bBrakingWindowElapsed;
 
-	// Apply friction
+	// Apply friction. Kept in line with ComputeGroundFrictionVelocity, but through ApplyVelocityBraking so subclasses can change braking.
 	if (bIsGroundMove)
 	{
 		const bool bVelocityOverMax = IsExceedingMaxSpeed(MaxSpeed);
@@ -1307,6 +2488,30 @@ void UPBPlayerMovement::CalcVelocity(float DeltaTime, float Friction, bool bFlui
 	// ladder movement
 	else if (bOnLadder)
 	{
+		if (bZeroAcceleration || !CurrentLadder.IsValid())
+		{
+			// Hold still on the ladder
+			Velocity = FVector::ZeroVector;
+		}
+		else
+		{
+			// Input moves us along where we look, pitch included
+			const FVector LadderNormal = CurrentLadder->GetLadderNormal();
+			const FRotator ControlRotation = CharacterOwner->GetControlRotation();
+			const FVector ViewForward = ControlRotation.Vector();
+			const FVector ViewRight = FRotationMatrix(ControlRotation).GetScaledAxis(EAxis::Y);
+			const FVector YawForward = FRotator(0.0f, ControlRotation.Yaw, 0.0f).Vector();
+			const FVector InputDir = Acceleration.GetSafeNormal2D();
+			FVector WishVelocity = (ViewForward * (InputDir | YawForward) + ViewRight * (InputDir | ViewRight)) * MaxSpeed;
+			// Pushing into the ladder climbs it, up unless we're looking down
+			const float IntoLadder = WishVelocity | LadderNormal;
+			if (IntoLadder < 0.0f)
+			{
+				WishVelocity -= IntoLadder * LadderNormal;
+				WishVelocity.Z += ViewForward.Z >= -0.5f ? -IntoLadder : IntoLadder;
+			}
+			Velocity = WishVelocity.GetClampedToMaxSize(MaxSpeed);
+		}
 	}
 	// walk move
 	else
@@ -1314,31 +2519,10 @@ void UPBPlayerMovement::CalcVelocity(float DeltaTime, float Friction, bool bFlui
 		// Apply input acceleration
 		if (!bZeroAcceleration)
 		{
-			// Clamp acceleration to max speed
+			// Clamp acceleration to max speed, callers (like the jump boost) read it back
 			Acceleration = Acceleration.GetClampedToMaxSize2D(MaxSpeed);
-			// Find veer
-			const FVector AccelDir = Acceleration.GetSafeNormal2D();
-			const float Veer = Velocity.X * AccelDir.X + Velocity.Y * AccelDir.Y;
-			// Get add speed with air speed cap
-			const float AddSpeed = (bIsGroundMove ? Acceleration : Acceleration.GetClampedToMaxSize2D(AirSpeedCap)).Size2D() - Veer;
-			if (AddSpeed > 0.0f)
-			{
-				// Apply acceleration
-				const float AccelerationMultiplier = bIsGroundMove ? GroundAccelerationMultiplier : AirAccelerationMultiplier;
-				FVector CurrentAcceleration = Acceleration * AccelerationMultiplier * SurfaceFriction * DeltaTime;
-				CurrentAcceleration = CurrentAcceleration.GetClampedToMaxSize2D(AddSpeed);
-				Velocity += CurrentAcceleration;
-			}
-		}
-
-		// No requested accel on player
-#if 0
-		// Apply additional requested acceleration
-		if (!bZeroRequestedAcceleration)
-		{
-			Velocity += RequestedAcceleration * DeltaTime;
+			Velocity = ComputeInputVelocity(Velocity, Acceleration, MaxSpeed, bIsGroundMove, SurfaceFriction, DeltaTime);
 		}
-#endif
 	}
 
 	// Limit after
@@ -1379,6 +2563,26 @@ void UPBPlayerMovement::CalcVelocity(float DeltaTime, float Friction, bool bFlui
 #endif
 }
 
+bool UPBPlayerMovement::ApplyRequestedMoveAsInput(float MaxAccel, float& OutRequestedSpeed)
+{
+	if (!bHasRequestedVelocity || bCheatFlying || bOnLadder)
+	{
+		return false;
+	}
+
+	const float RequestedSpeed = RequestedVelocity.Size2D();
+	if (RequestedSpeed < KINDA_SMALL_NUMBER)
+	{
+		return false;
+	}
+
+	// Full input toward where the path wants us, like a player holding the stick
+	Acceleration = RequestedVelocity.GetSafeNormal2D() * MaxAccel;
+	AnalogInputModifier = 1.0f;
+	OutRequestedSpeed = bRequestedMoveWithMaxSpeed ? BIG_NUMBER : RequestedSpeed;
+	return true;
+}
+
 void UPBPlayerMovement::Crouch(bool bClientSimulation)
 {
 	// TODO: replicate to the client simulation that we are in a crouch transition so they can do the resize too.
@@ -1390,7 +2594,7 @@ void UPBPlayerMovement::Crouch(bool bClientSimulation)
 	bIsInCrouchTransition = true;
 }
 
-void UPBPlayerMovement::DoCrouchResize(float TargetTime, float DeltaTime, bool bClientSimulation)
+void UPBPlayerMovement::DoCrouchResize(EPBCrouchTransition Transition, float DeltaTime, bool bClientSimulation)
 {
 	// UE4-COPY: void UCharacterMovementComponent::Crouch(bool bClientSimulation)
 
@@ -1400,44 +2604,47 @@ void UPBPlayerMovement::DoCrouchResize(float TargetTime, float DeltaTime, bool b
 		return;
 	}
 
+	const FPBCrouchGeometry& CrouchGeometry = GetCrouchGeometry();
+
 	// See if collision is already at desired size.
 	UCapsuleComponent* CharacterCapsule = CharacterOwner->GetCapsuleComponent();
-	if (FMath::IsNearlyEqual(CharacterCapsule->GetUnscaledCapsuleHalfHeight(), CrouchedHalfHeight))
+	if (FMath::IsNearlyEqual(CharacterCapsule->GetUnscaledCapsuleHalfHeight(), CrouchGeometry.CrouchedHalfHeight))
 	{
 		if (!bClientSimulation)
 		{
 			CharacterOwner->bIsCrouched = true;
 		}
+		SetCrouchAlpha(1.0f);
 		CharacterOwner->OnStartCrouch(0.0f, 0.0f);
 		bIsInCrouchTransition = false;
 		return;
 	}
 
-	ACharacter* DefaultCharacter = CharacterOwner->GetClass()->GetDefaultObject<ACharacter>();
-
 	if (bClientSimulation && CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy)
 	{
 		// restore collision size before crouching
-		CharacterCapsule->SetCapsuleSize(DefaultCharacter->GetCapsuleComponent()->GetUnscaledCapsuleRadius(), DefaultCharacter->GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight());
+		CharacterCapsule->SetCapsuleSize(CrouchGeometry.Radius, CrouchGeometry.StandingHalfHeight);
 		bShrinkProxyCapsule = true;
 	}
 
 	// Change collision size to crouching dimensions
 	const float ComponentScale = CharacterCapsule->GetShapeScale();
-	const float OldUnscaledHalfHeight = DefaultCharacter->GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight();
+	const float OldUnscaledHalfHeight = CrouchGeometry.StandingHalfHeight;
 	const float OldUnscaledRadius = CharacterCapsule->GetUnscaledCapsuleRadius();
-	const float FullCrouchDiff = OldUnscaledHalfHeight - CrouchedHalfHeight;
+	const float FullCrouchDiff = CrouchGeometry.FullCrouchDiff;
 	const float CurrentUnscaledHalfHeight = CharacterCapsule->GetUnscaledCapsuleHalfHeight();
 	// Determine the crouching progress
+	const float TargetTime = GetCrouchTransitionTime(Transition);
 	const bool bInstantCrouch = FMath::IsNearlyZero(TargetTime);
-	const float CurrentAlpha = 1.0f - (CurrentUnscaledHalfHeight - CrouchedHalfHeight) / FullCrouchDiff;
-	// Determine how much we are progressing this tick
+	const float CurrentAlpha = 1.0f - (CurrentUnscaledHalfHeight - CrouchGeometry.CrouchedHalfHeight) / FullCrouchDiff;
+	// Determine how much we are progressing this tick, resuming the curve from wherever the capsule is
 	float TargetAlphaDiff = 1.0f;
 	float TargetAlpha = 1.0f;
 	if (!bInstantCrouch)
 	{
-		TargetAlphaDiff = DeltaTime / CrouchTime;
-		TargetAlpha = CurrentAlpha + TargetAlphaDiff;
+		const FPBCrouchCurve& Curve = GetCrouchCurve(Transition);
+		TargetAlpha = Curve.Evaluate(Curve.InverseEvaluate(CurrentAlpha) + DeltaTime / TargetTime);
+		TargetAlphaDiff = TargetAlpha - CurrentAlpha;
 	}
 	if (TargetAlpha >= 1.0f || FMath::IsNearlyEqual(TargetAlpha, 1.0f))
 	{
@@ -1471,8 +2678,9 @@ void UPBPlayerMovement::DoCrouchResize(float TargetTime, float DeltaTime, bool b
 
 	bForceNextFloorCheck = true;
 
-	const float MeshAdjust = DefaultCharacter->GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight() - ClampedCrouchedHalfHeight;
+	const float MeshAdjust = CrouchGeometry.StandingHalfHeight - ClampedCrouchedHalfHeight;
 	AdjustProxyCapsuleSize();
+	SetCrouchAlpha(TargetAlpha);
 	CharacterOwner->OnStartCrouch(MeshAdjust, MeshAdjust * ComponentScale);
 
 	// Don't smooth this change in mesh position
@@ -1498,7 +2706,7 @@ void UPBPlayerMovement::UnCrouch(bool bClientSimulation)
 	bIsInCrouchTransition = true;
 }
 
-void UPBPlayerMovement::DoUnCrouchResize(float TargetTime, float DeltaTime, bool bClientSimulation)
+void UPBPlayerMovement::DoUnCrouchResize(EPBCrouchTransition Transition, float DeltaTime, bool bClientSimulation)
 {
 	// UE4-COPY: void UCharacterMovementComponent::UnCrouch(bool bClientSimulation)
 
@@ -1508,17 +2716,18 @@ void UPBPlayerMovement::DoUnCrouchResize(float TargetTime, float DeltaTime, bool
 		return;
 	}
 
-	ACharacter* DefaultCharacter = CharacterOwner->GetClass()->GetDefaultObject<ACharacter>();
+	const FPBCrouchGeometry& CrouchGeometry = GetCrouchGeometry();
 
 	UCapsuleComponent* CharacterCapsule = CharacterOwner->GetCapsuleComponent();
 
 	// See if collision is already at desired size.
-	if (FMath::IsNearlyEqual(CharacterCapsule->GetUnscaledCapsuleHalfHeight(), DefaultCharacter->GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight()))
+	if (FMath::IsNearlyEqual(CharacterCapsule->GetUnscaledCapsuleHalfHeight(), CrouchGeometry.StandingHalfHeight))
 	{
 		if (!bClientSimulation)
 		{
 			CharacterOwner->bIsCrouched = false;
 		}
+		SetCrouchAlpha(0.0f);
 		CharacterOwner->OnEndCrouch(0.0f, 0.0f);
 		bCrouchFrameTolerated = false;
 		bIsInCrouchTransition = false;
@@ -1529,28 +2738,36 @@ void UPBPlayerMovement::DoUnCrouchResize(float TargetTime, float DeltaTime, bool
 
 	const float ComponentScale = CharacterCapsule->GetShapeScale();
 	const float OldUnscaledHalfHeight = CharacterCapsule->GetUnscaledCapsuleHalfHeight();
-	const float UncrouchedHeight = DefaultCharacter->GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight();
-	const float FullCrouchDiff = UncrouchedHeight - CrouchedHalfHeight;
+	const float UncrouchedHeight = CrouchGeometry.StandingHalfHeight;
+	const float FullCrouchDiff = CrouchGeometry.FullCrouchDiff;
 	// Determine the crouching progress
+	const float TargetTime = GetCrouchTransitionTime(Transition);
 	const bool InstantCrouch = FMath::IsNearlyZero(TargetTime);
 	float CurrentAlpha = 1.0f - (UncrouchedHeight - OldUnscaledHalfHeight) / FullCrouchDiff;
 	float TargetAlphaDiff = 1.0f;
 	float TargetAlpha = 1.0f;
 	const UWorld* MyWorld = GetWorld();
 	const FVector PawnLocation = UpdatedComponent->GetComponentLocation();
+	if (!bClientSimulation && HeadroomCache.IsStillBlocked(PawnLocation, OldUnscaledHalfHeight, HeadroomCacheTolerance))
+	{
+		// Nothing that blocked our last attempt has moved, and neither have we
+		INC_DWORD_STAT(STAT_PBUncrouchOverlapTestsSkipped);
+		return;
+	}
 	if (!InstantCrouch)
 	{
-		TargetAlphaDiff = DeltaTime / TargetTime;
-		TargetAlpha = CurrentAlpha + TargetAlphaDiff;
+		const FPBCrouchCurve& Curve = GetCrouchCurve(Transition);
+		TargetAlpha = Curve.Evaluate(Curve.InverseEvaluate(CurrentAlpha) + DeltaTime / TargetTime);
+		TargetAlphaDiff = TargetAlpha - CurrentAlpha;
 		// Don't partial uncrouch in tight places (like vents)
 		if (bCrouchMaintainsBaseLocation)
 		{
 			// Try to stay in place and see if the larger capsule fits. We use a
 			// slightly taller capsule to avoid penetration.
 			const float SweepInflation = KINDA_SMALL_NUMBER * 10.0f;
-			FCollisionQueryParams CapsuleParams(SCENE_QUERY_STAT(CrouchTrace), false, CharacterOwner);
-			FCollisionResponseParams ResponseParam;
-			InitCollisionParams(CapsuleParams, ResponseParam);
+			const FPBQueryParams& Params = GetQueryParams(EPBQueryParams::CrouchOverlap);
+			const FCollisionQueryParams& CapsuleParams = Params.QueryParams;
+			const FCollisionResponseParams& ResponseParam = Params.ResponseParams;
 
 			// Check how much we have left to go (with some wiggle room to still allow for partial uncrouches in some areas)
 			const float HalfHeightAdjust = ComponentScale * (UncrouchedHeight - OldUnscaledHalfHeight) * GroundUncrouchCheckFactor;
@@ -1561,9 +2778,11 @@ void UPBPlayerMovement::DoUnCrouchResize(float TargetTime, float DeltaTime, bool
 			const ECollisionChannel CollisionChannel = UpdatedComponent->GetCollisionObjectType();
 			FVector StandingLocation = PawnLocation + FVector(0.0f, 0.0f, StandingCapsuleShape.GetCapsuleHalfHeight() - CurrentCrouchedHalfHeight);
 			bool bEncroached = MyWorld->OverlapBlockingTestByChannel(StandingLocation, FQuat::Identity, CollisionChannel, StandingCapsuleShape, CapsuleParams, ResponseParam);
+			INC_DWORD_STAT(STAT_PBUncrouchOverlapTests);
 			if (bEncroached)
 			{
 				// We're blocked from doing a full uncrouch, so don't attempt for now
+				CacheHeadroomBlockers(MakeArrayView(&StandingLocation, 1), StandingCapsuleShape, CapsuleParams, ResponseParam, OldUnscaledHalfHeight);
 				return;
 			}
 		}
@@ -1585,9 +2804,9 @@ void UPBPlayerMovement::DoUnCrouchResize(float TargetTime, float DeltaTime, bool
 		// Try to stay in place and see if the larger capsule fits. We use a
 		// slightly taller capsule to avoid penetration.
 		const float SweepInflation = KINDA_SMALL_NUMBER * 10.0f;
-		FCollisionQueryParams CapsuleParams(SCENE_QUERY_STAT(CrouchTrace), false, CharacterOwner);
-		FCollisionResponseParams ResponseParam;
-		InitCollisionParams(CapsuleParams, ResponseParam);
+		const FPBQueryParams& Params = GetQueryParams(EPBQueryParams::CrouchOverlap);
+		const FCollisionQueryParams& CapsuleParams = Params.QueryParams;
+		const FCollisionResponseParams& ResponseParam = Params.ResponseParams;
 
 		// Compensate for the difference between current capsule size and
 		// standing size
@@ -1595,14 +2814,19 @@ void UPBPlayerMovement::DoUnCrouchResize(float TargetTime, float DeltaTime, bool
 		const FCollisionShape StandingCapsuleShape = GetPawnCapsuleCollisionShape(SHRINK_HeightCustom, -SweepInflation - ScaledHalfHeightAdjust);
 		const ECollisionChannel CollisionChannel = UpdatedComponent->GetCollisionObjectType();
 		bool bEncroached = true;
+		// Where each test that found us encroached ran
+		TArray<FVector, TInlineAllocator<2>> EncroachedLocations;
 
 		if (!bCrouchMaintainsBaseLocation)
 		{
 			// Expand in place
 			bEncroached = MyWorld->OverlapBlockingTestByChannel(PawnLocation, FQuat::Identity, CollisionChannel, StandingCapsuleShape, CapsuleParams, ResponseParam);
+			INC_DWORD_STAT(STAT_PBUncrouchOverlapTests);
 
 			if (bEncroached)
 			{
+				EncroachedLocations.Add(PawnLocation);
+
 				// Try adjusting capsule position to see if we can avoid
 				// encroachment.
 				if (ScaledHalfHeightAdjust > 0.0f)
@@ -1628,7 +2852,12 @@ void UPBPlayerMovement::DoUnCrouchResize(float TargetTime, float DeltaTime, bool
 						const float DistanceToBase = (Hit.Time * TraceDist) + ShortCapsuleShape.Capsule.HalfHeight;
 						const FVector NewLoc = FVector(PawnLocation.X, PawnLocation.Y, PawnLocation.Z - DistanceToBase + StandingCapsuleShape.Capsule.HalfHeight + SweepInflation + MIN_FLOOR_DIST / 2.0f);
 						bEncroached = MyWorld->OverlapBlockingTestByChannel(NewLoc, FQuat::Identity, CollisionChannel, StandingCapsuleShape, CapsuleParams, ResponseParam);
-						if (!bEncroached)
+						INC_DWORD_STAT(STAT_PBUncrouchOverlapTests);
+						if (bEncroached)
+						{
+							EncroachedLocations.Add(NewLoc);
+						}
+						else
 						{
 							// Intentionally not using MoveUpdatedComponent,
 							// where a horizontal plane constraint would prevent
@@ -1645,9 +2874,12 @@ void UPBPlayerMovement::DoUnCrouchResize(float TargetTime, float DeltaTime, bool
 			// Expand while keeping base location the same.
 			FVector StandingLocation = PawnLocation + FVector(0.0f, 0.0f, StandingCapsuleShape.GetCapsuleHalfHeight() - CurrentCrouchedHalfHeight);
 			bEncroached = MyWorld->OverlapBlockingTestByChannel(StandingLocation, FQuat::Identity, CollisionChannel, StandingCapsuleShape, CapsuleParams, ResponseParam);
+			INC_DWORD_STAT(STAT_PBUncrouchOverlapTests);
 
 			if (bEncroached)
 			{
+				EncroachedLocations.Add(StandingLocation);
+
 				if (IsMovingOnGround())
 				{
 					// Something might be just barely overhead, try moving down
@@ -1657,6 +2889,11 @@ void UPBPlayerMovement::DoUnCrouchResize(float TargetTime, float DeltaTime, bool
 					{
 						StandingLocation.Z -= CurrentFloor.FloorDist - MinFloorDist;
 						bEncroached = MyWorld->OverlapBlockingTestByChannel(StandingLocation, FQuat::Identity, CollisionChannel, StandingCapsuleShape, CapsuleParams, ResponseParam);
+						INC_DWORD_STAT(STAT_PBUncrouchOverlapTests);
+						if (bEncroached)
+						{
+							EncroachedLocations.Add(StandingLocation);
+						}
 					}
 				}
 			}
@@ -1672,9 +2909,12 @@ void UPBPlayerMovement::DoUnCrouchResize(float TargetTime, float DeltaTime, bool
 		// If still encroached then abort.
 		if (bEncroached)
 		{
+			// A fallback test can fail on a different blocker than the first, any of them leaving could let us stand
+			CacheHeadroomBlockers(EncroachedLocations, StandingCapsuleShape, CapsuleParams, ResponseParam, OldUnscaledHalfHeight);
 			return;
 		}
 
+		HeadroomCache.Reset();
 		CharacterOwner->bIsCrouched = false;
 	}
 	else
@@ -1683,11 +2923,12 @@ void UPBPlayerMovement::DoUnCrouchResize(float TargetTime, float DeltaTime, bool
 	}
 
 	// Now call SetCapsuleSize() to cause touch/untouch events and actually grow the capsule
-	CharacterCapsule->SetCapsuleSize(DefaultCharacter->GetCapsuleComponent()->GetUnscaledCapsuleRadius(), OldUnscaledHalfHeight + HalfHeightAdjust, true);
+	CharacterCapsule->SetCapsuleSize(CrouchGeometry.Radius, OldUnscaledHalfHeight + HalfHeightAdjust, true);
 
 	// OnEndCrouch takes the change from the Default size, not the current one (though they are usually the same).
-	const float MeshAdjust = DefaultCharacter->GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight() - OldUnscaledHalfHeight + HalfHeightAdjust;
+	const float MeshAdjust = CrouchGeometry.StandingHalfHeight - OldUnscaledHalfHeight + HalfHeightAdjust;
 	AdjustProxyCapsuleSize();
+	SetCrouchAlpha(1.0f - TargetAlpha);
 	CharacterOwner->OnEndCrouch(MeshAdjust, MeshAdjust * ComponentScale);
 	bCrouchFrameTolerated = false;
 
@@ -1703,38 +2944,278 @@ void UPBPlayerMovement::DoUnCrouchResize(float TargetTime, float DeltaTime, bool
 	}
 }
 
-bool UPBPlayerMovement::MoveUpdatedComponentImpl(const FVector& Delta, const FQuat& NewRotation, bool bSweep, FHitResult* OutHit, ETeleportType Teleport)
+void UPBPlayerMovement::CacheHeadroomBlockers(TArrayView<const FVector> TestLocations, const FCollisionShape& TestShape, const FCollisionQueryParams& QueryParams, const FCollisionResponseParams& ResponseParam, float UnscaledHalfHeight)
 {
-	FVector NewDelta = Delta;
-	if (bSweep && Teleport == ETeleportType::None && Delta != FVector::ZeroVector && IsFalling() && Delta.Z > 0.0f)
-	{
-		const float HorizontalMovement = Delta.SizeSquared2D();
-		if (HorizontalMovement > KINDA_SMALL_NUMBER)
-		{
-			float PawnRadius, PawnHalfHeight;
-			CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleSize(PawnRadius, PawnHalfHeight);
-			FVector LineTraceStart = UpdatedComponent->GetComponentLocation();
-			// Shrink our base height so we don't intersect any current floor, and find where we would end up if we moved
-			LineTraceStart.Z += -PawnHalfHeight + MAX_FLOOR_DIST + Delta.Z;
-			// Inflate our search radius so we can anticipate new surfaces
-			FVector DeltaDir = Delta.GetSafeNormal2D() * (PawnRadius + SWEEP_EDGE_REJECT_DISTANCE);
-			FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(CapsuleHemisphereTrace), false, CharacterOwner);
-			FCollisionResponseParams ResponseParam;
-			InitCollisionParams(QueryParams, ResponseParam);
-			const ECollisionChannel CollisionChannel = UpdatedComponent->GetCollisionObjectType();
-			FHitResult Hit(1.f);
-			const bool bBlockingHit = GetWorld()->LineTraceSingleByChannel(Hit, LineTraceStart, LineTraceStart + DeltaDir, CollisionChannel, QueryParams, ResponseParam);
-			if (bBlockingHit && FMath::Abs(Hit.ImpactNormal.Z) <= VERTICAL_SLOPE_NORMAL_Z)
+	HeadroomCache.Reset();
+
+	// One more query per failed test to learn what is in the way, so we can skip testing again until it moves
+	TArray<FOverlapResult> Overlaps;
+	for (const FVector& TestLocation : TestLocations)
+	{
+		Overlaps.Reset();
+		GetWorld()->OverlapMultiByChannel(Overlaps, TestLocation, FQuat::Identity, UpdatedComponent->GetCollisionObjectType(), TestShape, QueryParams, ResponseParam);
+		INC_DWORD_STAT(STAT_PBUncrouchOverlapTests);
+		bool bFoundBlocker = false;
+		for (const FOverlapResult& Overlap : Overlaps)
+		{
+			UPrimitiveComponent* Blocker = Overlap.GetComponent();
+			if (Overlap.bBlockingHit && Blocker)
 			{
-				// DrawDebugLine(GetWorld(), LineTraceStart, LineTraceStart + DeltaDir, FColor::Red, false, 10.0f, 0, 0.5f);
-				// UE_LOG(LogTemp, Log, TEXT("%f"), Hit.ImpactNormal.Z);
-				//  Blocked horizontally by box
-				NewDelta = Super::ComputeSlideVector(Delta, 1.0f, Hit.ImpactNormal, Hit);
+				bFoundBlocker = true;
+				if (!HeadroomCache.Blockers.ContainsByPredicate([Blocker](const TPair<TWeakObjectPtr<UPrimitiveComponent>, FTransform>& Cached) { return Cached.Key == Blocker; }))
+				{
+					HeadroomCache.Blockers.Emplace(Blocker, Blocker->GetComponentTransform());
+				}
 			}
 		}
+
+		// Can't tell when this test would pass, so don't skip it
+		if (!bFoundBlocker)
+		{
+			HeadroomCache.Reset();
+			return;
+		}
+	}
+
+	if (HeadroomCache.Blockers.Num() > 0)
+	{
+		HeadroomCache.PawnLocation = UpdatedComponent->GetComponentLocation();
+		HeadroomCache.UnscaledHalfHeight = UnscaledHalfHeight;
+		HeadroomCache.bValid = true;
+	}
+}
+
+bool UPBPlayerMovement::FPBHeadroomCache::IsStillBlocked(const FVector& InPawnLocation, float InUnscaledHalfHeight, float Tolerance) const
+{
+	if (!bValid || !FMath::IsNearlyEqual(UnscaledHalfHeight, InUnscaledHalfHeight) || FVector::DistSquared(PawnLocation, InPawnLocation) > FMath::Square(Tolerance))
+	{
+		return false;
+	}
+	for (const TPair<TWeakObjectPtr<UPrimitiveComponent>, FTransform>& Blocker : Blockers)
+	{
+		const UPrimitiveComponent* Component = Blocker.Key.Get();
+		if (!Component || !Component->IsCollisionEnabled() || !Component->GetComponentTransform().Equals(Blocker.Value, KINDA_SMALL_NUMBER))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool UPBPlayerMovement::MoveUpdatedComponentImpl(const FVector& Delta, const FQuat& NewRotation, bool bSweep, FHitResult* OutHit, ETeleportType Teleport)
+{
+	const bool bAirborneSweep = bSweep && Teleport == ETeleportType::None && IsFalling();
+	if (!bAirborneSweep || Delta.Z <= 0.0f || Delta.SizeSquared2D() <= KINDA_SMALL_NUMBER)
+	{
+		return Super::MoveUpdatedComponentImpl(Delta, NewRotation, bSweep, OutHit, Teleport);
+	}
+
+	// Moving up in the air, sweep first and only look for a box wall when the sweep ran into something
+	FHitResult LocalHit(1.f);
+	FHitResult* SweepHit = OutHit ? OutHit : &LocalHit;
+	const bool bMoved = Super::MoveUpdatedComponentImpl(Delta, NewRotation, bSweep, SweepHit, Teleport);
+	INC_DWORD_STAT(STAT_PBAirborneMoveQueries);
+
+	FVector WallNormal;
+	if (SweepHit->bBlockingHit && !SweepHit->bStartPenetrating && FindAnticipatedWall(*SweepHit, Delta, WallNormal))
+	{
+		// Blocked horizontally by box, slide the rest of the move along its face instead of the edge we caught
+		SweepHit->Normal = WallNormal;
+		SweepHit->ImpactNormal = WallNormal;
+	}
+
+	return bMoved;
+}
+
+bool UPBPlayerMovement::FindAnticipatedWall(const FHitResult& SweepHit, const FVector& Delta, FVector& OutWallNormal)
+{
+	// Already sliding along a wall
+	if (FMath::Abs(SweepHit.Normal.Z) <= VERTICAL_SLOPE_NORMAL_Z)
+	{
+		return false;
+	}
+
+	float PawnRadius, PawnHalfHeight;
+	CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleSize(PawnRadius, PawnHalfHeight);
+	FVector LineTraceStart = UpdatedComponent->GetComponentLocation();
+	// Only our base can catch the top edge of a box
+	if (SweepHit.ImpactPoint.Z > LineTraceStart.Z)
+	{
+		return false;
+	}
+
+	// Shrink our base height so we don't intersect any current floor, and find where we would end up if we kept moving
+	LineTraceStart.Z += -PawnHalfHeight + MAX_FLOOR_DIST + Delta.Z * (1.f - SweepHit.Time);
+	// Inflate our search radius so we can anticipate new surfaces
+	const FVector DeltaDir = Delta.GetSafeNormal2D() * (PawnRadius + SWEEP_EDGE_REJECT_DISTANCE);
+
+	const FPBQueryParams& Params = GetQueryParams(EPBQueryParams::HemisphereLine);
+	FHitResult Hit(1.f);
+	const bool bBlockingHit = GetWorld()->LineTraceSingleByChannel(Hit, LineTraceStart, LineTraceStart + DeltaDir, UpdatedComponent->GetCollisionObjectType(), Params.QueryParams, Params.ResponseParams);
+	INC_DWORD_STAT(STAT_PBAirborneMoveQueries);
+	INC_DWORD_STAT(STAT_PBAnticipationTraces);
+	// DrawDebugLine(GetWorld(), LineTraceStart, LineTraceStart + DeltaDir, FColor::Red, false, 10.0f, 0, 0.5f);
+	if (bBlockingHit && FMath::Abs(Hit.ImpactNormal.Z) <= VERTICAL_SLOPE_NORMAL_Z)
+	{
+		OutWallNormal = Hit.ImpactNormal;
+		return true;
+	}
+	return false;
+}
+
+bool UPBPlayerMovement::StepUp(const FVector& GravDir, const FVector& Delta, const FHitResult& Hit, FStepDownResult* OutStepDownResult)
+{
+	{
+		SCOPE_CYCLE_COUNTER(STAT_CharStepUp);
+
+		bool bSteppedUp = false;
+		if (GravDir == FVector(0.0f, 0.0f, -1.0f) && TryFlatBaseStepUp(Delta, Hit, OutStepDownResult, bSteppedUp))
+		{
+			INC_DWORD_STAT(STAT_PBStepUpFlatBase);
+			return bSteppedUp;
+		}
+	}
+
+	// Up, forward and down sweeps with slide handling
+	INC_DWORD_STAT(STAT_PBStepUpFallback);
+	return Super::StepUp(GravDir, Delta, Hit, OutStepDownResult);
+}
+
+bool UPBPlayerMovement::TryFlatBaseStepUp(const FVector& Delta, const FHitResult& InHit, FStepDownResult* OutStepDownResult, bool& bOutSteppedUp)
+{
+	// UE4-COPY: bool UCharacterMovementComponent::StepUp(const FVector& GravDir, const FVector& Delta, const FHitResult &InHit, FStepDownResult* OutStepDownResult)
+	// The engine can't know how high the step is, so it travels up the full step height, forward, then back down.
+	// With a flat base, a line probe tells us the step top, so we can travel up exactly that much and land on it.
+
+	bOutSteppedUp = false;
+
+	if (!bUseFlatBaseForFloorChecks || !IsMovingOnGround() || !CurrentFloor.IsWalkableFloor())
+	{
+		return false;
+	}
+
+	// Only vertical step sides, anything else is a ramp or ledge lip that the regular step up handles
+	if (FMath::Abs(InHit.ImpactNormal.Z) > MAX_STEP_SIDE_Z || InHit.bStartPenetrating)
+	{
+		return false;
+	}
+
+	if (!CanStepUp(InHit) || MaxStepHeight <= 0.0f)
+	{
+		// Not allowed at all, no need for the regular step up either
+		return true;
+	}
+
+	const FVector OldLocation = UpdatedComponent->GetComponentLocation();
+	float PawnRadius, PawnHalfHeight;
+	CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleSize(PawnRadius, PawnHalfHeight);
+
+	// Don't bother stepping up if top of capsule is hitting something.
+	const float InitialImpactZ = InHit.ImpactPoint.Z;
+	if (InitialImpactZ > OldLocation.Z + (PawnHalfHeight - PawnRadius))
+	{
+		return true;
+	}
+
+	// Since we float a variable amount off the floor, enforce max step height off the actual floor.
+	const float FloorDist = FMath::Max(0.0f, CurrentFloor.GetDistanceToFloor());
+	const float PawnFloorPointZ = OldLocation.Z - PawnHalfHeight - FloorDist;
+
+	// Don't step up if the impact is below us, accounting for distance from floor.
+	if (InitialImpactZ <= PawnFloorPointZ)
+	{
+		return true;
+	}
+
+	// Probe down onto the step top, just inside the face we ran into.
+	const FVector IntoStep = (-InHit.ImpactNormal).GetSafeNormal2D();
+	if (IntoStep.IsNearlyZero())
+	{
+		return false;
+	}
+	const float StepProbeInset = 2.0f;
+	FVector ProbeStart = InHit.ImpactPoint + IntoStep * StepProbeInset;
+	ProbeStart.Z = PawnFloorPointZ + MaxStepHeight + MIN_FLOOR_DIST;
+	FVector ProbeEnd = ProbeStart;
+	ProbeEnd.Z = PawnFloorPointZ;
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(StepUpProbe), false, CharacterOwner);
+	FCollisionResponseParams ResponseParam;
+	InitCollisionParams(QueryParams, ResponseParam);
+	const ECollisionChannel CollisionChannel = UpdatedComponent->GetCollisionObjectType();
+	FHitResult ProbeHit(1.0f);
+	GetWorld()->LineTraceSingleByChannel(ProbeHit, ProbeStart, ProbeEnd, CollisionChannel, QueryParams, ResponseParam);
+	INC_DWORD_STAT(STAT_PBStepUpFlatBaseQueries);
+
+	if (!ProbeHit.bBlockingHit || ProbeHit.bStartPenetrating || !IsWalkable(ProbeHit))
+	{
+		// Step top is out of reach, covered, or not something we can stand on
+		return false;
+	}
+
+	const float StepHeight = ProbeHit.ImpactPoint.Z - PawnFloorPointZ;
+	if (StepHeight > MaxStepHeight)
+	{
+		return true;
+	}
+	if (StepHeight <= 0.0f || !CanStepUp(ProbeHit))
+	{
+		return false;
+	}
+
+	// Scope our movement updates, and do not apply them until all intermediate moves are completed.
+	FScopedMovementUpdate ScopedStepUpMovement(UpdatedComponent, EScopedUpdate::DeferredUpdates);
+	const FQuat PawnRotation = UpdatedComponent->GetComponentQuat();
+
+	// Step up to hover over the step top the same as we hover over the floor, with enough clearance to not graze its edge
+	FHitResult SweepUpHit(1.0f);
+	const float StepTravelUpHeight = StepHeight + FMath::Max(0.0f, MIN_FLOOR_DIST - FloorDist);
+	MoveUpdatedComponent(FVector(0.0f, 0.0f, StepTravelUpHeight), PawnRotation, true, &SweepUpHit);
+	INC_DWORD_STAT(STAT_PBStepUpFlatBaseQueries);
+
+	if (SweepUpHit.bStartPenetrating || SweepUpHit.bBlockingHit)
+	{
+		// No headroom for the step
+		ScopedStepUpMovement.RevertMove();
+		return true;
+	}
+
+	// Step forward. Since we are already at the step top height, there is no need to step back down.
+	FHitResult Hit(1.0f);
+	MoveUpdatedComponent(Delta, PawnRotation, true, &Hit);
+	INC_DWORD_STAT(STAT_PBStepUpFlatBaseQueries);
+
+	if (Hit.bBlockingHit)
+	{
+		// Ran into something past the step, let the regular step up handle impacts and sliding
+		ScopedStepUpMovement.RevertMove();
+		return false;
+	}
+
+	// The step top we probed has to be under us where we end up, like the regular step down hit, or we'd be standing on a thin lip
+	const FVector NewLocation = UpdatedComponent->GetComponentLocation();
+	if (!IsWithinEdgeTolerance(NewLocation, ProbeHit.ImpactPoint, PawnRadius))
+	{
+		ScopedStepUpMovement.RevertMove();
+		return false;
 	}
 
-	return Super::MoveUpdatedComponentImpl(NewDelta, NewRotation, bSweep, OutHit, Teleport);
+	// The probe found our new floor, so walking doesn't have to find it again
+	if (OutStepDownResult)
+	{
+		FHitResult FloorHit = ProbeHit;
+		FloorHit.Location = NewLocation;
+		FloorHit.Normal = ProbeHit.ImpactNormal;
+		const float NewFloorDist = NewLocation.Z - PawnHalfHeight - ProbeHit.ImpactPoint.Z;
+		OutStepDownResult->FloorResult.SetFromSweep(FloorHit, NewFloorDist, IsWalkable(ProbeHit));
+		OutStepDownResult->bComputedFloor = true;
+	}
+
+	// Don't recalculate velocity based on this height adjustment, if considering vertical adjustments.
+	bJustTeleported |= !bMaintainHorizontalGroundVelocity;
+
+	bOutSteppedUp = true;
+	return true;
 }
 
 bool UPBPlayerMovement::CanAttemptJump() const
@@ -1759,6 +3240,10 @@ float UPBPlayerMovement::GetMaxSpeed() const
 	{
 		return (PBCharacter->IsSprinting() ? SprintSpeed : WalkSpeed) * 1.5f;
 	}
+	if (bOnLadder)
+	{
+		return LadderSpeed;
+	}
 	float Speed;
 	if (PBCharacter->IsSprinting())
 	{
@@ -0,0 +1,78 @@
+// Copyright Project Borealis
+
+#include "Character/PBSavedMove.h"
+
+#include "Character/PBPlayerCharacter.h"
+#include "Character/PBPlayerMovement.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("PB Saved Moves Combined"), STAT_PBSavedMovesCombined, STATGROUP_Character);
+
+void FSavedMove_PB::Clear()
+{
+	Super::Clear();
+
+	bSprinting = false;
+	bWantsToWalk = false;
+	bInCrouchTransition = false;
+	bBrakingWindowElapsed = false;
+	bOnLadder = false;
+}
+
+void FSavedMove_PB::SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData)
+{
+	Super::SetMoveFor(C, InDeltaTime, NewAccel, ClientData);
+
+	if (const APBPlayerCharacter* PBCharacter = Cast<APBPlayerCharacter>(C))
+	{
+		bSprinting = PBCharacter->IsSprinting();
+		bWantsToWalk = PBCharacter->DoesWantToWalk();
+	}
+	if (const UPBPlayerMovement* Movement = Cast<UPBPlayerMovement>(C->GetCharacterMovement()))
+	{
+		bInCrouchTransition = Movement->bIsInCrouchTransition;
+		bBrakingWindowElapsed = Movement->bBrakingWindowElapsed;
+		bOnLadder = Movement->bOnLadder;
+	}
+}
+
+bool FSavedMove_PB::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const
+{
+	const FSavedMove_PB* NewPBMove = static_cast<const FSavedMove_PB*>(NewMove.Get());
+
+	if (bSprinting != NewPBMove->bSprinting || bWantsToWalk != NewPBMove->bWantsToWalk || bOnLadder != NewPBMove->bOnLadder || bBrakingWindowElapsed != NewPBMove->bBrakingWindowElapsed)
+	{
+		return false;
+	}
+
+	// The capsule resizes every move of a crouch transition, and the rejump window is timed per move, so keep those moves apart
+	if (bInCrouchTransition || NewPBMove->bInCrouchTransition || !bBrakingWindowElapsed)
+	{
+		return false;
+	}
+
+	return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+}
+
+void FSavedMove_PB::CombineWith(const FSavedMove_Character* OldMove, ACharacter* InCharacter, APlayerController* PC, const FVector& OldStartLocation)
+{
+	Super::CombineWith(OldMove, InCharacter, PC, OldStartLocation);
+
+	// The combined move replays from the old move's start, so put its PB state back too
+	const FSavedMove_PB* OldPBMove = static_cast<const FSavedMove_PB*>(OldMove);
+	if (UPBPlayerMovement* Movement = Cast<UPBPlayerMovement>(InCharacter->GetCharacterMovement()))
+	{
+		Movement->bIsInCrouchTransition = OldPBMove->bInCrouchTransition;
+		Movement->bBrakingWindowElapsed = OldPBMove->bBrakingWindowElapsed;
+	}
+
+	INC_DWORD_STAT(STAT_PBSavedMovesCombined);
+}
+
+FNetworkPredictionData_Client_PB::FNetworkPredictionData_Client_PB(const UCharacterMovementComponent& ClientMovement) : Super(ClientMovement)
+{
+}
+
+FSavedMovePtr FNetworkPredictionData_Client_PB::AllocateNewMove()
+{
+	return FSavedMovePtr(new FSavedMove_PB());
+}
@@ -0,0 +1,302 @@
+// Copyright Project Borealis
+
+#include "Sound/PBMoveStepSoundSubsystem.h"
+
+#include "Components/PrimitiveComponent.h"
+#include "Engine/AssetManager.h"
+#include "Engine/Level.h"
+#include "Engine/StreamableManager.h"
+#include "Engine/World.h"
+#include "Materials/MaterialInterface.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "Sound/SoundCue.h"
+
+#include "Character/PBLadderVolume.h"
+#include "Sound/PBMoveStepSound.h"
+
+DEFINE_LOG_CATEGORY(LogPBMoveStepSound);
+
+DECLARE_CYCLE_STAT(TEXT("PB Step Sound Level Scan"), STAT_PBStepSoundLevelScan, STATGROUP_Character);
+DECLARE_MEMORY_STAT(TEXT("PB Step Sound Preloaded Memory"), STAT_PBStepSoundMemory, STATGROUP_Character);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("PB Step Sound Sets Preloaded"), STAT_PBStepSoundSetsPreloaded, STATGROUP_Character);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("PB Step Sound Loads On Use"), STAT_PBStepSoundLoadsOnUse, STATGROUP_Character);
+
+static constexpr uint64 SurfaceBit(uint8 Surface)
+{
+	return 1ull << Surface;
+}
+
+bool UPBMoveStepSoundSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// Dedicated servers never play step sounds
+	return !IsRunningDedicatedServer() && Super::ShouldCreateSubsystem(Outer);
+}
+
+void UPBMoveStepSoundSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UPBMoveStepSoundSubsystem::OnLevelAdded);
+}
+
+void UPBMoveStepSoundSubsystem::Deinitialize()
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+
+	for (const TSharedPtr<FStreamableHandle>& Handle : Handles)
+	{
+		Handle->ReleaseHandle();
+	}
+	Handles.Reset();
+	MoveStepSoundsBySurface.Reset();
+	RequestedMoveStepSounds.Reset();
+	RequestedSounds.Reset();
+	CountedSounds.Reset();
+
+	DEC_MEMORY_STAT_BY(STAT_PBStepSoundMemory, ResidentBytes);
+	ResidentBytes = 0;
+	MaxAudibleDistance = 0.0f;
+
+	Super::Deinitialize();
+}
+
+void UPBMoveStepSoundSubsystem::PreloadMoveStepSounds(const FMoveStepSoundMap& MoveStepSounds)
+{
+	// Scan the levels already loaded the first time a pawn registers, streamed levels are scanned as they are added
+	if (MoveStepSoundsBySurface.Num() == 0)
+	{
+		for (ULevel* Level : GetWorld()->GetLevels())
+		{
+			ScanLevel(Level);
+		}
+	}
+
+	for (const TPair<TEnumAsByte<EPhysicalSurface>, TSoftClassPtr<UPBMoveStepSound>>& Pair : MoveStepSounds)
+	{
+		if (!Pair.Value.IsNull())
+		{
+			MoveStepSoundsBySurface.FindOrAdd(Pair.Key.GetValue()).AddUnique(Pair.Value);
+		}
+	}
+
+	RequestLoads();
+}
+
+void UPBMoveStepSoundSubsystem::OnLevelAdded(ULevel* Level, UWorld* World)
+{
+	if (World != GetWorld())
+	{
+		return;
+	}
+
+	ScanLevel(Level);
+	RequestLoads();
+}
+
+void UPBMoveStepSoundSubsystem::ScanLevel(ULevel* Level)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PBStepSoundLevelScan);
+
+	if (!Level)
+	{
+		return;
+	}
+
+	// The default surface is the fallback for everything
+	SurfacesInWorld |= SurfaceBit(SurfaceType_Default);
+
+	TArray<UMaterialInterface*> Materials;
+	for (AActor* Actor : Level->Actors)
+	{
+		if (!Actor)
+		{
+			continue;
+		}
+		// Ladders play the SurfaceType1 sounds
+		if (Actor->IsA<APBLadderVolume>())
+		{
+			SurfacesInWorld |= SurfaceBit(SurfaceType1);
+			continue;
+		}
+
+		TInlineComponentArray<UPrimitiveComponent*> Components(Actor);
+		for (UPrimitiveComponent* Component : Components)
+		{
+			if (!Component->IsCollisionEnabled())
+			{
+				continue;
+			}
+
+			if (const UPhysicalMaterial* PhysMaterial = Component->BodyInstance.GetSimplePhysicalMaterial())
+			{
+				SurfacesInWorld |= SurfaceBit(PhysMaterial->SurfaceType);
+			}
+
+			Materials.Reset();
+			Component->GetUsedMaterials(Materials);
+			for (const UMaterialInterface* Material : Materials)
+			{
+				if (Material)
+				{
+					if (const UPhysicalMaterial* PhysMaterial = Material->GetPhysicalMaterial())
+					{
+						SurfacesInWorld |= SurfaceBit(PhysMaterial->SurfaceType);
+					}
+				}
+			}
+		}
+	}
+}
+
+void UPBMoveStepSoundSubsystem::RequestLoads()
+{
+	TArray<FSoftObjectPath> ClassPaths;
+	for (const TPair<uint8, TArray<TSoftClassPtr<UPBMoveStepSound>, TInlineAllocator<1>>>& Pair : MoveStepSoundsBySurface)
+	{
+		if (!(SurfacesInWorld & SurfaceBit(Pair.Key)))
+		{
+			continue;
+		}
+		for (const TSoftClassPtr<UPBMoveStepSound>& MoveStepSound : Pair.Value)
+		{
+			const FSoftObjectPath& Path = MoveStepSound.ToSoftObjectPath();
+			if (!RequestedMoveStepSounds.Contains(Path))
+			{
+				RequestedMoveStepSounds.Add(Path);
+				ClassPaths.Add(Path);
+			}
+		}
+	}
+
+	LoadMoveStepSounds(MoveTemp(ClassPaths));
+}
+
+void UPBMoveStepSoundSubsystem::LoadMoveStepSounds(TArray<FSoftObjectPath> ClassPaths)
+{
+	if (ClassPaths.Num() == 0)
+	{
+		return;
+	}
+
+	TArray<FSoftObjectPath> RequestPaths = ClassPaths;
+	TSharedPtr<FStreamableHandle> Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(MoveTemp(RequestPaths), FStreamableDelegate::CreateUObject(this, &UPBMoveStepSoundSubsystem::OnMoveStepSoundsLoaded, ClassPaths, FPlatformTime::Seconds()));
+	if (Handle.IsValid())
+	{
+		Handles.Add(Handle);
+	}
+}
+
+void UPBMoveStepSoundSubsystem::OnMoveStepSoundsLoaded(TArray<FSoftObjectPath> ClassPaths, double StartTime)
+{
+	TArray<FSoftObjectPath> SoundPaths;
+	for (const FSoftObjectPath& Path : ClassPaths)
+	{
+		if (const UClass* Class = Cast<UClass>(Path.ResolveObject()))
+		{
+			Class->GetDefaultObject<UPBMoveStepSound>()->GetAllSounds(SoundPaths);
+		}
+	}
+	INC_DWORD_STAT_BY(STAT_PBStepSoundSetsPreloaded, ClassPaths.Num());
+
+	if (SoundPaths.Num() == 0)
+	{
+		return;
+	}
+
+	TArray<FSoftObjectPath> RequestPaths = SoundPaths;
+	TSharedPtr<FStreamableHandle> Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(MoveTemp(RequestPaths), FStreamableDelegate::CreateUObject(this, &UPBMoveStepSoundSubsystem::OnSoundsLoaded, SoundPaths, StartTime));
+	if (Handle.IsValid())
+	{
+		Handles.Add(Handle);
+	}
+}
+
+void UPBMoveStepSoundSubsystem::OnSoundsLoaded(TArray<FSoftObjectPath> SoundPaths, double StartTime)
+{
+	int64 LoadedBytes = 0;
+	int32 NumLoaded = 0;
+	for (const FSoftObjectPath& Path : SoundPaths)
+	{
+		bool bAlreadyCounted = false;
+		CountedSounds.Add(Path, &bAlreadyCounted);
+		if (bAlreadyCounted)
+		{
+			continue;
+		}
+		if (USoundCue* Sound = Cast<USoundCue>(Path.ResolveObject()))
+		{
+			LoadedBytes += Sound->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+			++NumLoaded;
+			MaxAudibleDistance = FMath::Max(MaxAudibleDistance, Sound->GetMaxDistance());
+		}
+	}
+	ResidentBytes += LoadedBytes;
+	INC_MEMORY_STAT_BY(STAT_PBStepSoundMemory, LoadedBytes);
+
+	UE_LOG(LogPBMoveStepSound, Log, TEXT("Loaded %d step sounds (%.1f KB) in %.1f ms, %.1f KB resident"), NumLoaded, LoadedBytes / 1024.0, (FPlatformTime::Seconds() - StartTime) * 1000.0, ResidentBytes / 1024.0);
+}
+
+void UPBMoveStepSoundSubsystem::LoadMoveStepSoundOnUse(const FSoftObjectPath& ClassPath)
+{
+	if (RequestedMoveStepSounds.Contains(ClassPath))
+	{
+		return;
+	}
+	RequestedMoveStepSounds.Add(ClassPath);
+
+	INC_DWORD_STAT(STAT_PBStepSoundLoadsOnUse);
+	UE_LOG(LogPBMoveStepSound, Verbose, TEXT("Loading step sound set %s on first use, its surface was not found in the level scan"), *ClassPath.ToString());
+
+	TArray<FSoftObjectPath> ClassPaths;
+	ClassPaths.Add(ClassPath);
+	LoadMoveStepSounds(MoveTemp(ClassPaths));
+}
+
+void UPBMoveStepSoundSubsystem::LoadSoundOnUse(const FSoftObjectPath& SoundPath)
+{
+	if (RequestedSounds.Contains(SoundPath))
+	{
+		return;
+	}
+	RequestedSounds.Add(SoundPath);
+
+	INC_DWORD_STAT(STAT_PBStepSoundLoadsOnUse);
+	UE_LOG(LogPBMoveStepSound, Verbose, TEXT("Loading step sound %s on first use"), *SoundPath.ToString());
+
+	// Also requested if its set is still streaming in, the streamable manager shares the in-flight load
+	TArray<FSoftObjectPath> SoundPaths;
+	SoundPaths.Add(SoundPath);
+	TArray<FSoftObjectPath> RequestPaths = SoundPaths;
+	TSharedPtr<FStreamableHandle> Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(MoveTemp(RequestPaths), FStreamableDelegate::CreateUObject(this, &UPBMoveStepSoundSubsystem::OnSoundsLoaded, SoundPaths, FPlatformTime::Seconds()));
+	if (Handle.IsValid())
+	{
+		Handles.Add(Handle);
+	}
+}
+
+UPBMoveStepSound* UPBMoveStepSoundSubsystem::ResolveMoveStepSound(const UWorld* World, const TSoftClassPtr<UPBMoveStepSound>& MoveStepSound)
+{
+	UClass* Class = MoveStepSound.Get();
+	if (!Class && !MoveStepSound.IsNull())
+	{
+		// Never load on the game thread mid-move, skip this sound and have the set ready for the next one
+		if (UPBMoveStepSoundSubsystem* Subsystem = UWorld::GetSubsystem<UPBMoveStepSoundSubsystem>(World))
+		{
+			Subsystem->LoadMoveStepSoundOnUse(MoveStepSound.ToSoftObjectPath());
+		}
+	}
+	return Class ? Class->GetDefaultObject<UPBMoveStepSound>() : nullptr;
+}
+
+USoundCue* UPBMoveStepSoundSubsystem::ResolveSound(const UWorld* World, const TSoftObjectPtr<USoundCue>& Sound)
+{
+	USoundCue* Cue = Sound.Get();
+	if (!Cue && !Sound.IsNull())
+	{
+		if (UPBMoveStepSoundSubsystem* Subsystem = UWorld::GetSubsystem<UPBMoveStepSoundSubsystem>(World))
+		{
+			Subsystem->LoadSoundOnUse(Sound.ToSoftObjectPath());
+		}
+	}
+	return Cue;
+}
@@ -0,0 +1,66 @@
+// Copyright Project Borealis
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Components/ActorComponent.h"
+
+#include "PBCameraEffectsComponent.generated.h"
+
+struct FMinimalViewInfo;
+
+/**
+ * Cosmetic view effects of a PB pawn's movement: velocity roll, view bob and land bounce.
+ * Evaluated once per frame on the final view, so they never touch control rotation
+ * and never end up in saved moves.
+ */
+UCLASS(ClassGroup = Camera, meta = (BlueprintSpawnableComponent))
+class PBCHARACTERMOVEMENT_API UPBCameraEffectsComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UPBCameraEffectsComponent();
+
+	/** Apply the effects to the view. Only the first call in a frame advances them. */
+	void ApplyToView(float DeltaTime, FMinimalViewInfo& InOutView);
+
+	/** Kick the view down for a landing at this fall speed, if it is fast enough */
+	void AddLandBounce(float FallSpeed);
+
+	/** Height of the view bob */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Camera Effects", meta = (ClampMin = "0", UIMin = "0"))
+	float BobAmplitude = 0.0f;
+
+	/** Horizontal distance travelled over a full bob, a left and a right step */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Camera Effects", meta = (ClampMin = "1", UIMin = "1"))
+	float BobCycleLength = 289.52f;
+
+	/** How far the view drops per unit of fall speed above the minimum land bounce speed */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Camera Effects", meta = (ClampMin = "0", UIMin = "0"))
+	float LandBounceScale = 0.0f;
+
+	/** Most the view can drop from a landing */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Camera Effects", meta = (ClampMin = "0", UIMin = "0"))
+	float MaxLandBounce = 8.0f;
+
+	/** Stiffness of the spring returning the view after a landing */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Camera Effects", meta = (ClampMin = "0", UIMin = "0"))
+	float LandBounceStiffness = 120.0f;
+
+private:
+	/** Frame the effects were last advanced on */
+	uint64 LastFrame = MAX_uint64;
+
+	/** Roll, bob and land bounce offsets from the last evaluation */
+	FVector Effects = FVector::ZeroVector;
+
+	/** Bob phase, in cycles */
+	float BobPhase = 0.0f;
+
+	/** Bob height scale, blended towards 1 while moving on the ground */
+	float BobWeight = 0.0f;
+
+	float LandBounceVelocity = 0.0f;
+};
@@ -0,0 +1,60 @@
+// Copyright Project Borealis
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Containers/StaticArray.h"
+
+/** Where a pawn's capsule was at one point in time */
+struct FPBCapsuleHistorySample
+{
+	/** Server world time of the sample */
+	float Time = 0.0f;
+
+	FVector Location = FVector::ZeroVector;
+	FQuat Rotation = FQuat::Identity;
+
+	/** Scaled capsule half height, which changes over crouch transitions */
+	float HalfHeight = 0.0f;
+};
+
+/** Fixed size ring of recent capsule samples for server side rewind, never allocates */
+struct PBCHARACTERMOVEMENT_API FPBCapsuleHistory
+{
+	static constexpr int32 MaxSamples = 64;
+
+	/** Add a sample. Samples not newer than the last one replace it. */
+	void Record(float Time, const FVector& Location, const FQuat& Rotation, float HalfHeight);
+
+	/**
+	 * Capsule at a past time, interpolated between the samples around it.
+	 * Times before the oldest sample clamp to it. Returns false if there are no samples.
+	 */
+	bool Rewind(float Time, FPBCapsuleHistorySample& OutSample) const;
+
+	void Reset()
+	{
+		NumSamples = 0;
+		Head = 0;
+	}
+
+	int32 Num() const
+	{
+		return NumSamples;
+	}
+
+	/** Sample by age, 0 being the newest */
+	const FPBCapsuleHistorySample& GetSample(int32 Age) const
+	{
+		check(Age >= 0 && Age < NumSamples);
+		return Samples[(Head - Age + MaxSamples) % MaxSamples];
+	}
+
+private:
+	TStaticArray<FPBCapsuleHistorySample, MaxSamples> Samples;
+
+	/** Index of the newest sample */
+	int32 Head = 0;
+	int32 NumSamples = 0;
+};
@@ -0,0 +1,94 @@
+// Copyright Project Borealis
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Subsystems/WorldSubsystem.h"
+
+#include "PBCorrectionTelemetrySubsystem.generated.h"
+
+class UNetConnection;
+
+/** PB state that was changing on the server when a client was corrected */
+enum class EPBCorrectionCause : uint8
+{
+	None = 0,
+	MovementMode = 1 << 0,
+	CrouchTransition = 1 << 1,
+	SprintChange = 1 << 2,
+	FrictionChange = 1 << 3,
+	CatchAir = 1 << 4
+};
+ENUM_CLASS_FLAGS(EPBCorrectionCause);
+
+/**
+ * Counts server corrections of client moves by connection and by the PB state that changed on the server that move,
+ * with a rolling histogram of correction size. Dump with pb.DumpCorrections.
+ */
+UCLASS()
+class PBCHARACTERMOVEMENT_API UPBCorrectionTelemetrySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Causes tracked separately, plus one for corrections with no cause */
+	static constexpr int32 NumCauses = 6;
+
+	/** Histogram buckets by correction size, doubling from 1 unit */
+	static constexpr int32 NumMagnitudeBuckets = 10;
+
+	/** Corrections the rolling histogram covers */
+	static constexpr int32 RollingWindow = 1024;
+
+	virtual void Deinitialize() override;
+
+	void RecordCorrection(const UNetConnection* Connection, EPBCorrectionCause Causes, float Magnitude);
+
+	/** Write per-connection counts and the rolling histogram as CSV. Returns the file written. */
+	FString DumpCsv() const;
+
+	static const TCHAR* GetCauseName(int32 CauseIndex);
+
+private:
+	struct FConnectionCorrections
+	{
+		/** Remote address when the row was added */
+		FString Name;
+		int32 Total = 0;
+		int32 ByCause[NumCauses] = {};
+
+		void Add(EPBCorrectionCause Causes);
+		void Add(const FConnectionCorrections& Other);
+	};
+
+	struct FRecentCorrection
+	{
+		EPBCorrectionCause Causes;
+		int32 Bucket;
+	};
+
+	static int32 GetMagnitudeBucket(float Magnitude);
+
+	/** Update the histogram for a correction entering or leaving the window */
+	void AddToHistogram(const FRecentCorrection& Correction, int32 Count);
+
+	/** Fold the rows of closed connections into DisconnectedCorrections, so reconnects don't grow the map forever */
+	void PruneConnections();
+
+	/** Rows of the open connections */
+	TMap<TWeakObjectPtr<const UNetConnection>, FConnectionCorrections> Connections;
+
+	/** Corrections of locally controlled pawns */
+	FConnectionCorrections LocalCorrections;
+
+	/** Corrections of connections that have since closed */
+	FConnectionCorrections DisconnectedCorrections;
+
+	/** Ring of the most recent corrections, so old ones can leave the histogram */
+	TArray<FRecentCorrection> Recent;
+	int32 RecentHead = 0;
+
+	/** Rolling count of corrections per cause and size bucket */
+	int32 Histogram[NumCauses][NumMagnitudeBuckets] = {};
+};
@@ -0,0 +1,73 @@
+// Copyright Project Borealis
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Engine/EngineTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "PBFloorSurfaceSubsystem.generated.h"
+
+class UMaterialInterface;
+class UPhysicalMaterial;
+class UPrimitiveComponent;
+class UStaticMesh;
+
+/** Surface properties of a floor, as PB movement uses them */
+struct FPBFloorSurface
+{
+	float Friction = 1.0f;
+	TEnumAsByte<EPhysicalSurface> SurfaceType = SurfaceType_Default;
+};
+
+/**
+ * Surface properties of static mesh floors whose every face has the same physical material,
+ * so pawns standing on them can skip the complex trace that finds the face's material.
+ * Entries are resolved on first query and checked against the component's mesh and materials on each lookup.
+ */
+UCLASS()
+class PBCHARACTERMOVEMENT_API UPBFloorSurfaceSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Entries kept before the cache is flushed, e.g. after a lot of level streaming */
+	static constexpr int32 MaxEntries = 4096;
+
+	virtual void Deinitialize() override;
+
+	/**
+	 * Surface of a floor component, if the whole component has one.
+	 * @return False if the floor's surface varies by face, and has to be traced
+	 */
+	bool FindSurface(const UPrimitiveComponent* Component, FPBFloorSurface& OutSurface);
+
+	/** Friction PB movement uses for a physical material */
+	static float GetFriction(const UPhysicalMaterial* PhysMaterial);
+
+private:
+	struct FEntry
+	{
+		TWeakObjectPtr<const UPrimitiveComponent> Component;
+
+		/** What the surface was resolved from, to notice the component changing mesh or material */
+		const UStaticMesh* StaticMesh = nullptr;
+		const UPhysicalMaterial* PhysMaterialOverride = nullptr;
+		/** Material of the simple shapes, which complex traces hit when the mesh traces simple as complex */
+		const UPhysicalMaterial* SimplePhysMaterial = nullptr;
+		TArray<const UMaterialInterface*, TInlineAllocator<4>> Materials;
+
+		/** False if the faces have different physical materials */
+		bool bUniform = false;
+		FPBFloorSurface Surface;
+	};
+
+	/** Fill in an entry from the component */
+	static void Resolve(const UPrimitiveComponent* Component, FEntry& Entry);
+
+	/** If the entry still matches the component */
+	static bool IsEntryValid(const UPrimitiveComponent* Component, const FEntry& Entry);
+
+	TMap<const UPrimitiveComponent*, FEntry> Entries;
+};
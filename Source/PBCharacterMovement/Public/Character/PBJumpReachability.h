@@ -0,0 +1,59 @@
+// Copyright Project Borealis
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UPBPlayerMovement;
+
+/** Movement state a jump is made from */
+enum class EPBJumpReachState : uint8
+{
+	Run,
+	Sprint,
+	/** Running jump, crouching in the air to pull the feet up */
+	CrouchJump,
+	Count
+};
+
+/**
+ * Envelopes of the heights a jump can reach at each horizontal distance, generated from the PB physics.
+ * Distances and heights are measured from the pawn's location at takeoff.
+ */
+struct PBCHARACTERMOVEMENT_API FPBJumpReachability
+{
+	/** Horizontal distance covered by each envelope entry */
+	static constexpr float BucketSize = 16.0f;
+
+	/** How far below takeoff we follow the fall */
+	static constexpr float MaxDropHeight = 1024.0f;
+
+	/** Build the tables for a movement component's current tuning */
+	static TSharedRef<const FPBJumpReachability> Generate(const UPBPlayerMovement& Movement);
+
+	/** Hash of every tuning value the tables depend on */
+	static uint32 GetTuningHash(const UPBPlayerMovement& Movement);
+
+	/** Highest height reachable at this horizontal distance, or -MaxDropHeight if out of range */
+	float GetMaxHeight(EPBJumpReachState State, bool bJumpBoost, float HorizontalDistance) const;
+
+	/** If a jump from this state can get the pawn to this offset */
+	bool CanReach(EPBJumpReachState State, bool bJumpBoost, float HorizontalDistance, float Height) const
+	{
+		return Height <= GetMaxHeight(State, bJumpBoost, HorizontalDistance);
+	}
+
+	/** Furthest horizontal distance reachable at this height, or 0 if none */
+	float GetMaxDistance(EPBJumpReachState State, bool bJumpBoost, float Height) const;
+
+	uint32 TuningHash = 0;
+
+private:
+	const TArray<float>& GetEnvelope(EPBJumpReachState State, bool bJumpBoost) const
+	{
+		return Envelopes[(int32)State][bJumpBoost ? 1 : 0];
+	}
+
+	/** Highest reachable height per distance bucket, never increasing with distance */
+	TArray<float> Envelopes[(int32)EPBJumpReachState::Count][2];
+};
@@ -0,0 +1,34 @@
+// Copyright Project Borealis
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Subsystems/WorldSubsystem.h"
+
+#include "PBJumpReachabilitySubsystem.generated.h"
+
+struct FPBJumpReachability;
+class UPBPlayerMovement;
+
+/**
+ * Jump reachability tables of a world by movement tuning, so bots sharing a pawn class only generate them once.
+ * Game thread only.
+ */
+UCLASS()
+class PBCHARACTERMOVEMENT_API UPBJumpReachabilitySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Tunings kept before the tables are flushed, e.g. while tweaking movement values live */
+	static constexpr int32 MaxTunings = 32;
+
+	virtual void Deinitialize() override;
+
+	/** Tables for a movement component's current tuning, generating them if no pawn with that tuning asked yet */
+	TSharedRef<const FPBJumpReachability> FindOrGenerate(const UPBPlayerMovement& Movement, uint32 TuningHash);
+
+private:
+	TMap<uint32, TSharedRef<const FPBJumpReachability>> ReachabilityByTuning;
+};
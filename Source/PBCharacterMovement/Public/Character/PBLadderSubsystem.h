@@ -0,0 +1,51 @@
+// Copyright Project Borealis
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Subsystems/WorldSubsystem.h"
+
+#include "PBLadderSubsystem.generated.h"
+
+class APBLadderVolume;
+
+/**
+ * Spatial hash of the ladder volumes in a world, so a pawn can find the ladder it
+ * touches with a handful of cell lookups instead of overlap events or traces.
+ */
+UCLASS()
+class PBCHARACTERMOVEMENT_API UPBLadderSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Size of a hash cell. Ladders and pawns are much smaller, so a query rarely touches more than one cell. */
+	static constexpr float CellSize = 512.0f;
+
+	virtual void Deinitialize() override;
+
+	void RegisterLadder(APBLadderVolume* Ladder);
+	void UnregisterLadder(APBLadderVolume* Ladder);
+
+	/** Find a ladder touched by a capsule at this location, or null */
+	APBLadderVolume* FindLadder(const FVector& Location, float Radius, float HalfHeight) const;
+
+	int32 GetNumLadders() const
+	{
+		return NumLadders;
+	}
+
+private:
+	typedef TArray<APBLadderVolume*, TInlineAllocator<2>> FLadderCell;
+
+	static FIntVector GetCell(const FVector& Location)
+	{
+		return FIntVector(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize), FMath::FloorToInt(Location.Z / CellSize));
+	}
+
+	/** Ladders by every cell their bounds overlap */
+	TMap<FIntVector, FLadderCell> Cells;
+
+	int32 NumLadders = 0;
+};
@@ -0,0 +1,49 @@
+// Copyright Project Borealis
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "GameFramework/Actor.h"
+
+#include "PBLadderVolume.generated.h"
+
+class UBoxComponent;
+
+/**
+ * Climbable ladder region. The actor's forward vector is the ladder normal, pointing out from the climbing face.
+ * Ladders register with the world's ladder subsystem and are not expected to move during play.
+ */
+UCLASS()
+class PBCHARACTERMOVEMENT_API APBLadderVolume : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	APBLadderVolume(const FObjectInitializer& ObjectInitializer);
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Direction pointing away from the ladder's climbing face */
+	FVector GetLadderNormal() const
+	{
+		return GetActorForwardVector();
+	}
+
+	/** World space bounds of the climbable region */
+	FBox GetLadderBounds() const;
+
+	/** If a capsule at this location touches the climbable region */
+	bool IsCapsuleOnLadder(const FVector& Location, float Radius, float HalfHeight) const;
+
+	UBoxComponent* GetLadderBox() const
+	{
+		return LadderBox;
+	}
+
+private:
+	/** Climbable region */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"), Category = "Ladder")
+	UBoxComponent* LadderBox;
+};
@@ -0,0 +1,152 @@
+// Copyright Project Borealis
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "PBMovementTickSubsystem.generated.h"
+
+class UPBPlayerMovement;
+class UPBMovementTickSubsystem;
+class UPrimitiveComponent;
+
+/** Single tick function that drives every PB movement component registered with the world's tick subsystem. */
+USTRUCT()
+struct FPBMovementAggregateTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	/** The subsystem that owns this tick function */
+	UPBMovementTickSubsystem* Target = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template <>
+struct TStructOpsTypeTraits<FPBMovementAggregateTickFunction> : public TStructOpsTypeTraitsBase2<FPBMovementAggregateTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+/**
+ * Ticks all PB movement components of a world from one aggregated tick function,
+ * instead of dispatching a separate component tick per pawn.
+ */
+UCLASS()
+class PBCHARACTERMOVEMENT_API UPBMovementTickSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	/**
+	 * Start ticking this movement component from the aggregated tick. The component must disable its own tick.
+	 * @param bTickEnabled	Whether the component's own tick was enabled
+	 */
+	void RegisterMovement(UPBPlayerMovement* Movement, bool bTickEnabled);
+
+	/** Stop ticking this movement component from the aggregated tick. Safe to call while ticking. */
+	void UnregisterMovement(UPBPlayerMovement* Movement);
+
+	/** Enable or disable ticking a registered component, in place of its own disabled tick function */
+	void SetMovementTickEnabled(UPBPlayerMovement* Movement, bool bEnabled);
+
+	/** Tick every registered movement component */
+	void TickMovements(float DeltaTime, ELevelTick TickType);
+
+	int32 GetNumMovements() const
+	{
+		return Movements.Num();
+	}
+
+	/**
+	 * Queue a pawn's push on a physics body, to be applied together with every other push
+	 * on that body once all movement has ticked.
+	 * @param bImpulse	Apply as an impulse, else as a force
+	 */
+	void QueuePush(UPrimitiveComponent* Component, FName BoneName, const FVector& Push, const FVector& Location, bool bImpulse);
+
+	/** Apply the queued pushes, one linear and one angular impulse, and one force and one torque, per body */
+	void FlushPushes();
+
+private:
+	struct FRegisteredMovement
+	{
+		TWeakObjectPtr<UPBPlayerMovement> Movement;
+
+		/** Follows SetComponentTickEnabled and Activate/Deactivate, since the component's own tick function stays disabled */
+		bool bTickEnabled = true;
+
+		/** Time accumulated towards the component's tick interval */
+		float PendingDeltaTime = 0.0f;
+
+		/** Component tick prerequisites we mirrored onto the aggregated tick */
+		TArray<FTickPrerequisite, TInlineAllocator<2>> Prerequisites;
+
+		/** Actors and components of the owner whose tick waited on the component's tick, now waiting on the aggregated tick */
+		TArray<TWeakObjectPtr<UObject>, TInlineAllocator<2>> Dependents;
+	};
+
+	/** Mirror the component's own tick prerequisites (e.g. its controller) onto the aggregated tick */
+	void SyncPrerequisites(FRegisteredMovement& Entry);
+
+	/** Mirror one prerequisite onto the aggregated tick, or take another reference on it */
+	void AddPrerequisiteRef(const FTickPrerequisite& Prerequisite);
+
+	/** Drop a reference on a mirrored prerequisite, removing it from the aggregated tick once no component needs it */
+	void ReleasePrerequisiteRef(const FTickPrerequisite& Prerequisite);
+
+	/** Move whatever on the owner ticked after the component's tick onto the aggregated tick */
+	void RedirectDependents(FRegisteredMovement& Entry);
+
+	/** Put the owner's dependents back onto the component's tick */
+	void RestoreDependents(FRegisteredMovement& Entry);
+
+	/** Undo everything registering the entry did to the tick graph */
+	void ReleaseEntry(FRegisteredMovement& Entry);
+
+	FRegisteredMovement* FindEntry(const UPBPlayerMovement* Movement);
+
+	/** How many registered components have each prerequisite, so one leaving doesn't drop it for the others */
+	TMap<FTickFunction*, int32> PrerequisiteRefs;
+
+	/** Registered components, ticked in registration order so the order is the same every run */
+	TArray<FRegisteredMovement> Movements;
+
+	/** Set while ticking, when removals only clear the entry so the loop's indices stay valid */
+	bool bIsTickingMovements = false;
+
+	/** Set when entries were cleared while ticking and need compacting */
+	bool bHasClearedMovements = false;
+
+	/** Pushes on one body, summed into what they do to its center of mass, so pushes on opposite ends keep their torque */
+	struct FPendingPush
+	{
+		TWeakObjectPtr<UPrimitiveComponent> Component;
+		FName BoneName;
+
+		/** Body's center of mass when its first push was queued */
+		FVector CenterOfMass = FVector::ZeroVector;
+
+		FVector Impulse = FVector::ZeroVector;
+		FVector AngularImpulse = FVector::ZeroVector;
+		bool bHasImpulse = false;
+
+		FVector Force = FVector::ZeroVector;
+		FVector Torque = FVector::ZeroVector;
+		bool bHasForce = false;
+	};
+
+	/** Pushes queued this frame, by body */
+	TMap<TPair<const UPrimitiveComponent*, FName>, FPendingPush> PendingPushes;
+
+	FPBMovementAggregateTickFunction AggregateTick;
+};
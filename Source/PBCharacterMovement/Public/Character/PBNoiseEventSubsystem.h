@@ -0,0 +1,93 @@
+// Copyright Project Borealis
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Containers/StaticArray.h"
+#include "Templates/Atomic.h"
+#include "Engine/EngineTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "PBNoiseEventSubsystem.generated.h"
+
+class APawn;
+
+enum class EPBNoiseEventType : uint8
+{
+	Footstep,
+	Jump,
+	Land,
+};
+
+/** A noise made by a pawn moving */
+struct FPBNoiseEvent
+{
+	FVector Location = FVector::ZeroVector;
+	/** Volume of the sound played for it, 0 to 1 */
+	float Loudness = 0.0f;
+	/** World time the noise was made at */
+	float Time = 0.0f;
+	TWeakObjectPtr<APawn> Instigator;
+	TEnumAsByte<EPhysicalSurface> Surface = SurfaceType_Default;
+	EPBNoiseEventType Type = EPBNoiseEventType::Footstep;
+};
+
+/**
+ * Ring buffer of the movement noises made in a world, so AI hearing can read new noises
+ * in batches instead of polling every pawn. Readers keep their own cursor and don't lock.
+ * Noises hold weak pointers, which can't be copied while being written, so both writing
+ * and reading happen on the game thread.
+ */
+UCLASS()
+class PBCHARACTERMOVEMENT_API UPBNoiseEventSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Noises kept. A reader further behind than this misses the oldest ones. */
+	static constexpr uint32 Capacity = 256;
+
+	/** Add a noise, overwriting the oldest if full. Game thread only. */
+	void Publish(const FPBNoiseEvent& Event);
+
+	/** Cursor at the newest noise, for a reader that only wants noises from now on */
+	uint64 GetCursor() const
+	{
+		return WriteIndex;
+	}
+
+	/**
+	 * Read the noises published since the cursor that can be heard from a location, and advance the cursor.
+	 * A noise is heard within Radius scaled by its loudness, as AI hearing does. Game thread only.
+	 * @return The number of noises added to OutEvents
+	 */
+	int32 ReadEvents(uint64& Cursor, const FVector& Origin, float Radius, TArray<FPBNoiseEvent>& OutEvents) const;
+
+	/** Register something reading noises, so publishers know they are being listened to. Any thread. */
+	void AddReader()
+	{
+		NumReaders.IncrementExchange();
+	}
+
+	void RemoveReader()
+	{
+		NumReaders.DecrementExchange();
+	}
+
+	bool HasActiveReaders() const
+	{
+		return NumReaders.Load(EMemoryOrder::Relaxed) > 0;
+	}
+
+private:
+	static constexpr uint32 IndexMask = Capacity - 1;
+	static_assert((Capacity & IndexMask) == 0, "Noise event capacity must be a power of two");
+
+	TStaticArray<FPBNoiseEvent, Capacity> Events;
+
+	/** Total noises ever published, the next one goes in slot WriteIndex & IndexMask */
+	uint64 WriteIndex = 0;
+
+	TAtomic<int32> NumReaders{0};
+};
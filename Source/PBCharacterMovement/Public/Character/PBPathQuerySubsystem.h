@@ -0,0 +1,125 @@
+// Copyright Project Borealis
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "AI/Navigation/NavigationTypes.h"
+#include "NavigationData.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+
+#include "PBPathQuerySubsystem.generated.h"
+
+DECLARE_DELEGATE_OneParam(FPBPathQueryComplete, FNavPathSharedPtr /* Path */);
+
+/**
+ * Batches navmesh path queries for PB bots. Requests between nearby points on the same navmesh polys are merged,
+ * recent results are reused, and only a budgeted number of searches run per frame.
+ * Tuned in the [/Script/PBCharacterMovement.PBPathQuerySubsystem] section of DefaultGame.ini.
+ */
+UCLASS(config = Game)
+class PBCHARACTERMOVEMENT_API UPBPathQuerySubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	/** Start and end points are merged when within the same cell of this size, and on the same navmesh polys */
+	UPROPERTY(config)
+	float QuantizeSize = 50.0f;
+
+	/** Most path searches run per frame, the rest wait */
+	UPROPERTY(config)
+	int32 MaxQueriesPerTick = 8;
+
+	/** How long a found path is handed out again for the same request */
+	UPROPERTY(config)
+	float ResultLifetime = 0.5f;
+
+	virtual void Deinitialize() override;
+
+	/**
+	 * Queue a path search. The callback may run immediately if a recent result can be reused,
+	 * otherwise in a later frame. The path is null if none was found. Each request gets its own
+	 * copy of the path, running from its own start to its own end.
+	 */
+	void RequestPath(const FVector& Start, const FVector& End, const FNavAgentProperties& AgentProperties, FPBPathQueryComplete OnComplete);
+
+	int32 GetNumPendingQueries() const
+	{
+		return PendingQueries.Num();
+	}
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual ETickableTickType GetTickableTickType() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override
+	{
+		return GetWorld();
+	}
+
+private:
+	struct FQueryKey
+	{
+		FIntVector StartCell;
+		FIntVector EndCell;
+
+		/** Navmesh polys of the start and end. Points in one convex poly have a straight leg between them, so the path can be shared. */
+		NavNodeRef StartPoly;
+		NavNodeRef EndPoly;
+
+		const ANavigationData* NavData;
+
+		/** Non-zero for a request that can't be merged, since its points aren't on a navmesh poly */
+		uint32 Unique;
+
+		bool operator==(const FQueryKey& Other) const
+		{
+			return StartCell == Other.StartCell && EndCell == Other.EndCell && StartPoly == Other.StartPoly && EndPoly == Other.EndPoly && NavData == Other.NavData && Unique == Other.Unique;
+		}
+
+		friend uint32 GetTypeHash(const FQueryKey& Key)
+		{
+			uint32 Hash = HashCombine(GetTypeHash(Key.StartCell), GetTypeHash(Key.EndCell));
+			Hash = HashCombine(Hash, HashCombine(GetTypeHash(Key.StartPoly), GetTypeHash(Key.EndPoly)));
+			return HashCombine(HashCombine(Hash, GetTypeHash(Key.NavData)), Key.Unique);
+		}
+	};
+
+	struct FRequest
+	{
+		FVector Start;
+		FVector End;
+		FPBPathQueryComplete OnComplete;
+	};
+
+	struct FPendingQuery
+	{
+		FVector Start;
+		FVector End;
+		TArray<FRequest, TInlineAllocator<1>> Requests;
+	};
+
+	struct FCachedResult
+	{
+		/** Never handed out, requests get copies of it */
+		FNavPathSharedPtr Path;
+		float Time;
+	};
+
+	/** Key merging the request with others between nearby points on the same polys, or a unique key if its points aren't on the navmesh */
+	FQueryKey MakeKey(const FVector& Start, const FVector& End, const ANavigationData* NavData);
+
+	/** A request's own copy of a found path, with the request's start and end points */
+	static FNavPathSharedPtr CopyPath(const FNavPathSharedPtr& Path, const FVector& Start, const FVector& End);
+
+	/** Waiting searches, in request order */
+	TMap<FQueryKey, FPendingQuery> PendingQueries;
+
+	/** Recently found paths */
+	TMap<FQueryKey, FCachedResult> CachedResults;
+
+	/** Last unique key handed out to an unmergeable request */
+	uint32 LastUnique = 0;
+};
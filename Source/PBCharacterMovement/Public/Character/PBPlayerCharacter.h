@@ -9,6 +9,7 @@
 #include "PBPlayerCharacter.generated.h"
 
 class USoundCue;
+class UPBCameraEffectsComponent;
 class UPBMoveStepSound;
 class UPBPlayerMovement;
 
@@ -32,6 +33,19 @@ public:
 	virtual bool CanJumpInternal_Implementation() const override;
 
 	void RecalculateBaseEyeHeight() override;
+	virtual void CalcCamera(float DeltaTime, struct FMinimalViewInfo& OutResult) override;
+	virtual void Landed(const FHitResult& Hit) override;
+
+	/**
+	 * Velocity after the jump boost, without applying it.
+	 * @param Input		Input acceleration
+	 * @param Facing	Direction the pawn faces
+	 * @param bReducedBoost	If sprinting or crouched, which boost less
+	 */
+	FVector ComputeJumpBoostedVelocity(const FVector& InVelocity, const FVector& Input, const FVector& Facing, float MaxSpeed, bool bReducedBoost) const;
+
+	/** Set the crouch alpha sent to simulated proxies */
+	void SetReplicatedCrouchAlpha(float InCrouchAlpha);
 
 	/* Triggered when player's movement mode has changed */
 	void OnMovementModeChanged(EMovementMode PrevMovementMode, uint8 PrevCustomMode) override;
@@ -67,9 +81,9 @@ private:
 	UPROPERTY(EditAnywhere, meta = (AllowPrivateAccess = "true"), Category = "PB Player|Gameplay")
 	bool bAutoBunnyhop;
 
-	/** Move step sounds by physical surface */
+	/** Move step sounds by physical surface. Only the surfaces found in the loaded levels are preloaded. */
 	UPROPERTY(EditDefaultsOnly, meta = (AllowPrivateAccess = "true"), Category = "PB Player|Sounds")
-	TMap<TEnumAsByte<EPhysicalSurface>, TSubclassOf<UPBMoveStepSound>> MoveStepSounds;
+	TMap<TEnumAsByte<EPhysicalSurface>, TSoftClassPtr<UPBMoveStepSound>> MoveStepSounds;
 
 		/** Minimum speed to play the camera shake for landing */
 	UPROPERTY(EditDefaultsOnly, meta = (AllowPrivateAccess = "true"), Category = "PB Player|Damage")
@@ -86,6 +100,10 @@ private:
 	/** Pointer to player movement component */
 	UPBPlayerMovement* MovementPtr;
 
+	/** Velocity roll, view bob and land bounce */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"), Category = "PB Player|Camera")
+	UPBCameraEffectsComponent* CameraEffects;
+
 	/** True if we're sprinting*/
 	bool bIsSprinting;
 
@@ -94,10 +112,18 @@ private:
 	/** defer the jump stop for a frame (for early jumps) */
 	bool bDeferJumpStop;
 
+	/** Crouch transition alpha from the movement component, quantized to a byte for simulated proxies */
+	UPROPERTY(ReplicatedUsing = OnRep_CrouchAlpha)
+	uint8 ReplicatedCrouchAlpha;
+
+	UFUNCTION()
+	void OnRep_CrouchAlpha();
+
 	virtual void ApplyDamageMomentum(float DamageTaken, FDamageEvent const& DamageEvent, APawn* PawnInstigator, AActor* DamageCauser) override;
 
 protected:
 	virtual void BeginPlay();
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 public:
 	APBPlayerCharacter(const FObjectInitializer& ObjectInitializer);
 
@@ -112,10 +138,8 @@ public:
 	{
 		return bWantsToWalk;
 	}
-	FORCEINLINE TSubclassOf<UPBMoveStepSound>* GetMoveStepSound(TEnumAsByte<EPhysicalSurface> Surface)
-	{
-		return MoveStepSounds.Find(Surface);
-	};
+	/** Get the move step sound for a surface, or null if there isn't one */
+	UPBMoveStepSound* GetMoveStepSound(TEnumAsByte<EPhysicalSurface> Surface) const;
 	UFUNCTION(Category = "PB Getters", BlueprintPure) FORCEINLINE float GetBaseTurnRate() const
 	{
 		return BaseTurnRate;
@@ -8,6 +8,12 @@
 
 #include "Runtime/Launch/Resources/Version.h"
 
+#include "Character/PBCapsuleHistory.h"
+#include "Character/PBCorrectionTelemetrySubsystem.h"
+#include "Character/PBFloorSurfaceSubsystem.h"
+#include "Character/PBJumpReachability.h"
+#include "Character/PBRandomStream.h"
+
 #include "PBPlayerMovement.generated.h"
 
 #define LADDER_MOUNT_TIMEOUT 0.2f
@@ -19,19 +25,200 @@
 #define MOVEMENT_DEFAULT_UNCROUCHJUMPTIME 0.8f
 
 class USoundCue;
+class APBLadderVolume;
+enum class EPBNoiseEventType : uint8;
+
+/** Custom movement modes, used with MOVE_Custom */
+UENUM(BlueprintType)
+enum class EPBCustomMovementMode : uint8
+{
+	/** Climbing a ladder volume */
+	Ladder
+};
+
+/** Easing applied to the capsule (and with it the eye height) over a crouch transition */
+UENUM(BlueprintType)
+enum class EPBCrouchEasing : uint8
+{
+	Linear,
+	/** Smooth start and end, matching the old eye height easing */
+	SimpleSpline,
+	EaseIn,
+	EaseOut
+};
+
+/** Which of the crouch transitions is running */
+enum class EPBCrouchTransition : uint8
+{
+	Crouch,
+	Uncrouch,
+	CrouchJump,
+	UncrouchJump,
+	Count
+};
+
+/** Crouch easing curve sampled into a small table, mapping normalized transition time to progress */
+struct FPBCrouchCurve
+{
+	static constexpr int32 NumSegments = 32;
+
+	/** Progress at each of the evenly spaced times, strictly from 0 to 1 */
+	float Samples[NumSegments + 1];
+
+	EPBCrouchEasing Easing = EPBCrouchEasing::Linear;
+	bool bBuilt = false;
+
+	void Build(EPBCrouchEasing InEasing);
+
+	/** Progress at a normalized time */
+	float Evaluate(float Time) const;
+
+	/** Normalized time at which the curve reaches this progress, so a transition can resume from any capsule height */
+	float InverseEvaluate(float Progress) const;
+};
+
+/** Capsule and eye heights used by crouching, derived from the character's defaults */
+struct FPBCrouchGeometry
+{
+	/** Unscaled capsule half height when standing */
+	float StandingHalfHeight = 0.0f;
+
+	/** Unscaled capsule half height when fully crouched */
+	float CrouchedHalfHeight = 0.0f;
+
+	/** Unscaled default capsule radius */
+	float Radius = 0.0f;
+
+	/** Half height difference between standing and fully crouched */
+	float FullCrouchDiff = 0.0f;
+
+	float StandingEyeHeight = 0.0f;
+	float CrouchedEyeHeight = 0.0f;
+
+	/** Capsule shape scale these were computed at */
+	float ShapeScale = 0.0f;
+
+	bool bValid = false;
+};
+
+/** Collision queries PB movement runs every tick, each with its own prebuilt parameters */
+enum class EPBQueryParams : uint8
+{
+	/** Complex floor sweep returning physical materials */
+	FloorComplex,
+	/** Standing capsule overlap when uncrouching */
+	CrouchOverlap,
+	/** Line trace from the capsule hemisphere anticipating walls */
+	HemisphereLine,
+	Count
+};
+
+/** Query and response parameters for one of the PB queries, rebuilt when what they were built from changes */
+struct FPBQueryParams
+{
+	FCollisionQueryParams QueryParams;
+	FCollisionResponseParams ResponseParams;
+
+	/** Hash of the owner, ignore lists and collision responses these were built with */
+	uint32 Signature = 0;
+	bool bBuilt = false;
+};
+
+/** Pawn state for trajectory prediction, both the start and each predicted tick */
+struct FPBTrajectoryState
+{
+	FVector Location = FVector::ZeroVector;
+	FVector Velocity = FVector::ZeroVector;
+
+	bool bOnGround = false;
+
+	/** Friction of the surface we're on, see UPBPlayerMovement::SurfaceFriction */
+	float SurfaceFriction = 1.0f;
+
+	/** Braking window progress, in millis, see UPBPlayerMovement::BrakingWindow */
+	float BrakingWindowTimeElapsed = 0.0f;
+	bool bBrakingWindowElapsed = true;
+
+	/** If the cheap collision sweep hit something on this tick */
+	bool bBlocked = false;
+};
+
+/** Player input for one predicted tick */
+struct FPBTrajectoryInput
+{
+	/** Input acceleration, as in UCharacterMovementComponent::Acceleration */
+	FVector Acceleration = FVector::ZeroVector;
+
+	/** Facing yaw, used for the jump boost */
+	float Yaw = 0.0f;
+
+	/** Jump this tick if on the ground */
+	bool bJump = false;
+};
+
+struct FPBTrajectoryParams
+{
+	/** Length of one predicted tick */
+	float TimeStep = 1.0f / 60.0f;
+
+	/** Max speed to predict with, or 0 to use the pawn's current max speed */
+	float MaxSpeed = 0.0f;
+
+	/** Sweep the capsule once every this many ticks, or 0 to ignore collision */
+	int32 SweepInterval = 0;
+
+	bool bApplyJumpBoost = true;
+
+	/** Use the smaller jump boost of sprinting or crouched pawns */
+	bool bReducedJumpBoost = false;
+};
+
+/** Stride a footstep was taken with */
+UENUM(BlueprintType)
+enum class EPBStepStride : uint8
+{
+	Walk,
+	Run,
+	Sprint,
+	Crouch,
+	Ladder
+};
+
+/** A footstep, emitted each time the pawn has travelled a stride */
+struct FPBStepEvent
+{
+	/** World time the stride was completed at, which can be earlier in the tick than when it is emitted */
+	float Time = 0.0f;
+
+	/** Where the feet were when the stride was completed */
+	FVector Location = FVector::ZeroVector;
+
+	float Speed = 0.0f;
+
+	EPBStepStride Stride = EPBStepStride::Run;
+
+	/** Fast enough for sprint step sounds */
+	bool bSprinting = false;
+
+	bool bLeftStep = false;
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FPBOnStep, const FPBStepEvent&);
 
 UCLASS()
 class PBCHARACTERMOVEMENT_API UPBPlayerMovement : public UCharacterMovementComponent
 {
 	GENERATED_BODY()
 
+	friend class FSavedMove_PB;
+
 protected:
 	/** If the player is using a ladder */
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = Gameplay)
 	bool bOnLadder;
 
-	/** Milliseconds between step sounds */
-	float MoveSoundTime;
+	/** Distance left to travel before the next step */
+	float StepDistanceRemaining;
 
 	/** If we are stepping left, else, right */
 	bool StepSide;
@@ -64,6 +251,22 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Walking")
 	float UncrouchJumpTime;
 
+	/** Easing of the crouch on ground */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Walking")
+	EPBCrouchEasing CrouchEasing;
+
+	/** Easing of the uncrouch on ground */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Walking")
+	EPBCrouchEasing UncrouchEasing;
+
+	/** Easing of the crouch in air */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Walking")
+	EPBCrouchEasing CrouchJumpEasing;
+
+	/** Easing of the uncrouch in air */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Walking")
+	EPBCrouchEasing UncrouchJumpEasing;
+
 	/** the minimum step height from moving fast */
 	UPROPERTY(Category = "Character Movement: Walking", EditAnywhere, BlueprintReadWrite)
 	float MinStepHeight;
@@ -106,6 +309,61 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Ladder")
 	float LadderSpeed;
 
+	/** Split fast air moves into substeps, so surfing at high speed doesn't tunnel through geometry */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Jumping / Falling")
+	bool bUseAdaptiveAirSubstepping;
+
+	/** Largest distance moved in one air substep, as a fraction of capsule radius */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Jumping / Falling", meta = (ClampMin = "0.05", UIMin = "0.05", EditCondition = "bUseAdaptiveAirSubstepping"))
+	float AdaptiveSubstepRadiusFraction;
+
+	/** Cap on air substeps per tick, past which we accept longer steps */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Jumping / Falling", meta = (ClampMin = "1", UIMin = "1", EditCondition = "bUseAdaptiveAirSubstepping"))
+	int32 MaxAdaptiveSubsteps;
+
+	/** Keep a history of capsule positions on the server, for lag compensation */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement (Networking)")
+	bool bRecordCapsuleHistory = true;
+
+	/**
+	 * Seed for this pawn's randomness. Movement randomness (ditch escapes) is drawn from it and each move's timestamp,
+	 * so it must be the same on server and client. Cosmetic randomness (step sounds) with 0 derives a seed from the owner's name.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement (General Settings)")
+	int32 RandomSeed = 0;
+
+	/** Speed we are pushed away from the ladder when jumping off it */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Ladder")
+	float LadderJumpOffSpeed;
+
+	/** Horizontal distance between steps when walking */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Footsteps", meta = (ClampMin = "1", UIMin = "1"))
+	float WalkStrideLength;
+
+	/** Horizontal distance between steps when running */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Footsteps", meta = (ClampMin = "1", UIMin = "1"))
+	float RunStrideLength;
+
+	/** Horizontal distance between steps when sprinting */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Footsteps", meta = (ClampMin = "1", UIMin = "1"))
+	float SprintStrideLength;
+
+	/** Horizontal distance between steps when crouched */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Footsteps", meta = (ClampMin = "1", UIMin = "1"))
+	float CrouchStrideLength;
+
+	/** Distance climbed between steps on a ladder */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Footsteps", meta = (ClampMin = "1", UIMin = "1"))
+	float LadderStrideLength;
+
+	/** Loudness of a walking step or jump heard by AI, independent of the step sound assets so dedicated servers publish it too */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Footsteps", meta = (ClampMin = "0", UIMin = "0"))
+	float WalkNoiseLoudness;
+
+	/** Loudness of a sprinting step or jump heard by AI */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Footsteps", meta = (ClampMin = "0", UIMin = "0"))
+	float SprintNoiseLoudness;
+
 	/** The minimum speed to scale up from for slope movement  */
 	UPROPERTY(Category = "Character Movement: Walking", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0"))
 	float SpeedMultMin;
@@ -137,8 +395,20 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement (General Settings)")
 	float GroundUncrouchCheckFactor = 0.75f;
 
+	/** How far the pawn may move before a blocked uncrouch is tested again, while nothing blocking it has moved. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement (General Settings)", meta = (ClampMin = "0", UIMin = "0"))
+	float HeadroomCacheTolerance = 1.0f;
+
+	/** How far the pawn may move on a moving base before the floor under it is queried again. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement (General Settings)", meta = (ClampMin = "0", UIMin = "0"))
+	float BasedFloorTolerance = 1.0f;
+
 	bool bShouldPlayMoveSounds = true;
 
+	/** Tick from the world's aggregated PB movement tick instead of a separate component tick */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Character Movement (General Settings)")
+	bool bUseAggregatedTick = true;
+
 public:
 	/** Print pos and vel (Source: cl_showpos) */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement (General Settings)")
@@ -148,17 +418,78 @@ public:
 
 	virtual void InitializeComponent() override;
 	void OnRegister() override;
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void SetComponentTickEnabled(bool bEnabled) override;
+	virtual void MoveAutonomous(float ClientTimeStamp, float DeltaTime, uint8 CompressedFlags, const FVector& NewAccel) override;
+	virtual void PerformMovement(float DeltaTime) override;
+	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+	virtual void CallServerMove(const FSavedMove_Character* NewMove, const FSavedMove_Character* OldMove) override;
+	virtual bool ServerCheckClientError(float ClientTimeStamp, float DeltaTime, const FVector& Accel, const FVector& ClientWorldLocation, const FVector& RelativeClientLocation, UPrimitiveComponent* ClientMovementBase, FName ClientBaseBoneName, uint8 ClientMovementMode) override;
+
+	/** Capsule at a past server world time, interpolated from the recorded history, for server side rewind */
+	bool GetCapsuleAtTime(float ServerTime, FPBCapsuleHistorySample& OutSample) const;
+
+	const FPBCapsuleHistory& GetCapsuleHistory() const
+	{
+		return CapsuleHistory;
+	}
+
+	/** Called on each footstep, whether or not a sound is played for it */
+	FPBOnStep OnStep;
+
+	float GetStrideLength(EPBStepStride Stride) const;
+
+	/** Restart this pawn's randomness from a seed, e.g. to replay a recording */
+	void SetRandomSeed(int32 InRandomSeed);
+
+	/** Random stream for the move being performed, reseeded each time a move runs so replaying it draws the same values */
+	FPBRandomStream& GetMoveRandomStream()
+	{
+		return MoveRandomStream;
+	}
+
+	/** Random stream for cosmetics, which never affect the simulation */
+	FPBRandomStream& GetCosmeticRandomStream()
+	{
+		return CosmeticRandomStream;
+	}
 
 	// Overrides for Source-like movement
 	void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 	virtual void CalcVelocity(float DeltaTime, float Friction, bool bFluid, float BrakingDeceleration) override;
 	virtual void ApplyVelocityBraking(float DeltaTime, float Friction, float BrakingDeceleration) override;
+	/** Queues pushes on the aggregated tick, so all pawns' pushes on a body are applied at once */
+	virtual void ApplyImpactPhysicsForces(const FHitResult& Impact, const FVector& ImpactAcceleration, const FVector& ImpactVelocity) override;
+
+	/** Turn a path following velocity request into input acceleration. Returns false if there's no request. */
+	bool ApplyRequestedMoveAsInput(float MaxAccel, float& OutRequestedSpeed);
+
+	/** Velocity after braking, without touching the component */
+	FVector ComputeBrakedVelocity(const FVector& InVelocity, float DeltaTime, float Friction, float BrakingDeceleration) const;
+
+	/** Velocity after ground friction, which doesn't brake us below max speed if we were pushing past it */
+	FVector ComputeGroundFrictionVelocity(const FVector& InVelocity, const FVector& InAcceleration, float MaxSpeed, float Friction, float BrakingDeceleration, float InSurfaceFriction, float DeltaTime) const;
+
+	/** Velocity after input acceleration, with the air speed cap applied off the ground */
+	FVector ComputeInputVelocity(const FVector& InVelocity, const FVector& InAcceleration, float MaxSpeed, bool bGroundMove, float InSurfaceFriction, float DeltaTime) const;
 	void PhysFalling(float deltaTime, int32 Iterations);
+	void PhysCustom(float deltaTime, int32 Iterations) override;
+
+	/** How many iterations to split this falling tick into, based on how far we move */
+	int32 GetAdaptiveAirSubsteps(float DeltaTime) const;
+
+	/** Climb along the current ladder */
+	void PhysLadder(float deltaTime, int32 Iterations);
+
+	/** Mount or dismount ladders depending on where we are */
+	void UpdateLadderState(float DeltaSeconds);
 	bool ShouldLimitAirControl(float DeltaTime, const FVector& FallAcceleration) const override;
 	FVector NewFallVelocity(const FVector& InitialVelocity, const FVector& Gravity, float DeltaTime) const override;
 
 	void UpdateCharacterStateBeforeMovement(float DeltaSeconds) override;
 	void UpdateCharacterStateAfterMovement(float DeltaSeconds) override;
+	void UpdateBasedMovement(float DeltaSeconds) override;
 
 	void UpdateSurfaceFriction(bool bIsSliding = false);
 	void UpdateCrouching(float DeltaTime, bool bOnlyUnCrouch = false);
@@ -166,10 +497,11 @@ public:
 	// Overrides for crouch transitions
 	virtual void Crouch(bool bClientSimulation = false) override;
 	virtual void UnCrouch(bool bClientSimulation = false) override;
-	virtual void DoCrouchResize(float TargetTime, float DeltaTime, bool bClientSimulation = false);
-	virtual void DoUnCrouchResize(float TargetTime, float DeltaTime, bool bClientSimulation = false);
+	virtual void DoCrouchResize(EPBCrouchTransition Transition, float DeltaTime, bool bClientSimulation = false);
+	virtual void DoUnCrouchResize(EPBCrouchTransition Transition, float DeltaTime, bool bClientSimulation = false);
 	
 	bool MoveUpdatedComponentImpl(const FVector& Delta, const FQuat& NewRotation, bool bSweep, FHitResult* OutHit = nullptr, ETeleportType Teleport = ETeleportType::None) override;
+	bool StepUp(const FVector& GravDir, const FVector& Delta, const FHitResult& Hit, FStepDownResult* OutStepDownResult = nullptr) override;
 
 	// Jump overrides
 	bool CanAttemptJump() const override;
@@ -186,6 +518,9 @@ public:
 
 	void TraceCharacterFloor(FHitResult& OutHit);
 
+	/** Surface of the floor we stand on, from the floor surface cache if it can, else by tracing the floor */
+	FPBFloorSurface GetFloorSurface();
+
 	// Acceleration
 	FORCEINLINE FVector GetAcceleration() const
 	{
@@ -201,8 +536,13 @@ public:
 
 	virtual void OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode);
 
-	/** Do camera roll effect based on velocity */
-	float GetCameraRoll();
+	/**
+	 * Run the PB ground and air rules forward from a state without changing the component.
+	 * Ground is assumed to continue under a grounded pawn unless the optional sweeps find none within a step below it.
+	 * @param InputSequence	Input per tick, the last one is held if shorter than NumTicks
+	 * @param OutStates		One state per predicted tick
+	 */
+	void PredictTrajectory(const FPBTrajectoryState& StartState, TArrayView<const FPBTrajectoryInput> InputSequence, int32 NumTicks, const FPBTrajectoryParams& Params, TArray<FPBTrajectoryState>& OutStates) const;
 
 	void SetNoClip(bool bNoClip);
 
@@ -221,15 +561,206 @@ public:
 
 	virtual float GetMaxSpeed() const override;
 
+	/** Crouch capsule and eye heights, rebuilt if the capsule scale or crouch heights changed */
+	const FPBCrouchGeometry& GetCrouchGeometry() const;
+
+	/** How far through crouching we are, 0 standing to 1 fully crouched. Capsule and eye height are both linear in this. */
+	float GetCrouchAlpha() const
+	{
+		return CrouchAlpha;
+	}
+
+	/** Apply a crouch alpha received from the server, for simulated proxies */
+	void SetSimulatedCrouchAlpha(float InCrouchAlpha);
+
+	/** Force the crouch geometry to be rebuilt on next use */
+	void InvalidateCrouchGeometry()
+	{
+		CrouchGeometry.bValid = false;
+	}
+
+	/** Jump reachability tables for the current tuning, shared by every pawn tuned the same and regenerated when tuning changes */
+	const FPBJumpReachability& GetJumpReachability() const;
+
+	/** If a jump from this state can reach a spot at this horizontal distance and height from us */
+	bool CanReachByJump(EPBJumpReachState State, bool bJumpBoost, float HorizontalDistance, float Height) const
+	{
+		return GetJumpReachability().CanReach(State, bJumpBoost, HorizontalDistance, Height);
+	}
+
+	float GetRunSpeed() const
+	{
+		return RunSpeed;
+	}
+
+	float GetRollAngle() const
+	{
+		return RollAngle;
+	}
+
+	float GetRollSpeed() const
+	{
+		return RollSpeed;
+	}
+
+	float GetSprintSpeed() const
+	{
+		return SprintSpeed;
+	}
+
+	float GetAirSpeedCap() const
+	{
+		return AirSpeedCap;
+	}
+
+	float GetAirAccelerationMultiplier() const
+	{
+		return AirAccelerationMultiplier;
+	}
+
+	float GetAxisSpeedLimit() const
+	{
+		return AxisSpeedLimit;
+	}
+
 private:
+	/** Advance the step cadence by the distance travelled this tick, and take a step each stride */
+	void UpdateStepCadence(float DeltaTime);
+
 	/** Plays sound effect according to movement and surface */
-	void PlayMoveSound(float DeltaTime);
+	void PlayMoveSound(const FPBStepEvent& Step);
 
 	class UPBMoveStepSound* GetMoveStepSoundBySurface(EPhysicalSurface SurfaceType) const;
 
+	/** If a listener is within step sound range, or AI hearing is reading noises */
+	bool IsMoveSoundAudible() const;
+
 
 	virtual void PlayJumpSound(const FHitResult& Hit, bool bJumped);
 
+	/** Loudness of a jump, or of a landing at the current fall speed, from movement state alone */
+	float GetJumpNoiseLoudness(bool bJumped) const;
+
+	/** Tell AI hearing about a noise made at the feet */
+	void PublishNoiseEvent(EPBNoiseEventType Type, const FVector& Location, float Loudness, EPhysicalSurface Surface) const;
+
+	/**
+	 * Step up using the known step height under a flat base: probe the step top, then move up and forward.
+	 * The probed step top is the new floor, so it is handed back in the step down result.
+	 * Returns false if the step could not be resolved this way and the regular step up should be used instead.
+	 */
+	bool TryFlatBaseStepUp(const FVector& Delta, const FHitResult& InHit, FStepDownResult* OutStepDownResult, bool& bOutSteppedUp);
+
+	/** Floor and deflection results of a landing spot validation, reused when the same contact is validated again */
+	struct FPBLandingSpotMemo
+	{
+		FVector CapsuleLocation;
+		FVector ImpactPoint;
+		FVector ImpactNormal;
+		TWeakObjectPtr<UPrimitiveComponent> Component;
+		bool bStartPenetrating = false;
+
+		FFindFloorResult FloorResult;
+
+		/** Deflection off the hit surface, computed lazily from the velocity it was computed for */
+		bool bHasDeflection = false;
+		FVector DeflectionInput;
+		float DeflectionZ = 0.0f;
+
+		void Set(const FVector& InCapsuleLocation, const FHitResult& Hit)
+		{
+			CapsuleLocation = InCapsuleLocation;
+			ImpactPoint = Hit.ImpactPoint;
+			ImpactNormal = Hit.ImpactNormal;
+			Component = Hit.Component;
+			bStartPenetrating = Hit.bStartPenetrating;
+		}
+
+		bool Matches(const FVector& InCapsuleLocation, const FHitResult& Hit) const
+		{
+			return CapsuleLocation == InCapsuleLocation && ImpactPoint == Hit.ImpactPoint && ImpactNormal == Hit.ImpactNormal && Component == Hit.Component &&
+				   bStartPenetrating == Hit.bStartPenetrating;
+		}
+	};
+
+	/** What blocked our last uncrouch attempt, so we don't re-test the headroom until something moves */
+	struct FPBHeadroomCache
+	{
+		bool bValid = false;
+		FVector PawnLocation;
+		float UnscaledHalfHeight = 0.0f;
+		TArray<TPair<TWeakObjectPtr<UPrimitiveComponent>, FTransform>, TInlineAllocator<2>> Blockers;
+
+		bool IsStillBlocked(const FVector& InPawnLocation, float InUnscaledHalfHeight, float Tolerance) const;
+
+		void Reset()
+		{
+			bValid = false;
+			Blockers.Reset();
+		}
+	};
+
+	/** Floor under us on a moving base, kept in the base's space so it holds while the base carries us along */
+	struct FPBBasedFloorCache
+	{
+		TWeakObjectPtr<const UPrimitiveComponent> Base;
+		FName BoneName;
+
+		/** Pawn location in the base's space the floor was found from */
+		FVector RelativeLocation;
+
+		/** Floor found from there, with its hit in the base's space */
+		FFindFloorResult RelativeFloor;
+		bool bHasFloor = false;
+
+		FPBFloorSurface Surface;
+		bool bHasSurface = false;
+
+		/** If this is the cache for the base and the pawn hasn't moved on it */
+		bool Matches(const UPrimitiveComponent* InBase, FName InBoneName, const FVector& InRelativeLocation, float Tolerance) const;
+
+		/** Start over for a new base, or a new location on it */
+		void Reset(const UPrimitiveComponent* InBase, FName InBoneName, const FVector& InRelativeLocation);
+
+		/** Keep a floor found from the cached location, if it is on the base */
+		void SetFloor(const FFindFloorResult& Floor, const FTransform& BaseTransform);
+
+		/** The cached floor where the base is now */
+		void GetFloor(const FTransform& BaseTransform, FFindFloorResult& OutFloor) const;
+	};
+
+	/** Transform of a base that moves us with it. Returns false for static bases. */
+	static bool GetMovingBaseTransform(const UPrimitiveComponent* Base, FName BoneName, FTransform& OutTransform);
+
+	/** Remember what blocks standing up at these locations, every test that failed, so the cache lets go once any of them could pass */
+	void CacheHeadroomBlockers(TArrayView<const FVector> TestLocations, const FCollisionShape& TestShape, const FCollisionQueryParams& QueryParams, const FCollisionResponseParams& ResponseParam, float UnscaledHalfHeight);
+
+	/** Find the memo for validating this landing spot, finding the floor for it if it hasn't been validated yet */
+	FPBLandingSpotMemo& FindOrAddLandingSpotMemo(const FVector& CapsuleLocation, const FHitResult& Hit) const;
+
+	/** Recompute the crouch geometry from the character's defaults */
+	void UpdateCrouchGeometry() const;
+
+	/** Easing table for a transition, rebuilt if its easing setting changed */
+	const FPBCrouchCurve& GetCrouchCurve(EPBCrouchTransition Transition) const;
+
+	float GetCrouchTransitionTime(EPBCrouchTransition Transition) const;
+
+	/** Parameters for one of the PB queries, rebuilt if the owner's ignored actors or collision responses changed */
+	const FPBQueryParams& GetQueryParams(EPBQueryParams Query);
+
+	/** Hash of everything InitCollisionParams reads from the updated primitive */
+	uint32 GetQueryParamsSignature() const;
+
+	/** Store the crouch alpha and pass it on to the character for replication */
+	void SetCrouchAlpha(float InCrouchAlpha);
+
+	/**
+	 * Find the vertical wall under an edge our base caught while moving up in the air,
+	 * only traced when the move's sweep ran into something on a slope.
+	 */
+	bool FindAnticipatedWall(const FHitResult& SweepHit, const FVector& Delta, FVector& OutWallNormal);
+
 	float DefaultStepHeight;
 	float DefaultWalkableFloorZ;
 	float SurfaceFriction;
@@ -237,6 +768,63 @@ private:
 	/** The time that the player can remount on the ladder */
 	float OffLadderTicks = -1.0f;
 
+	/** Ladder we are climbing */
+	TWeakObjectPtr<APBLadderVolume> CurrentLadder;
+
 	bool bHasDeferredMovementMode;
 	EMovementMode DeferredMovementMode;
+
+	/** If we are currently ticked by the world's aggregated movement tick */
+	bool bIsAggregatedTicking = false;
+
+	/** Landing spots validated during the current falling iteration */
+	mutable TArray<FPBLandingSpotMemo, TInlineAllocator<4>> LandingSpotMemo;
+
+	/** If landing spot validations may be reused, only true while running a falling iteration */
+	bool bLandingSpotMemoActive = false;
+
+	FPBHeadroomCache HeadroomCache;
+
+	/** Written by landing validation, which is const */
+	mutable FPBBasedFloorCache BasedFloorCache;
+
+	/** Cached so crouch code doesn't look up the default character every tick */
+	mutable FPBCrouchGeometry CrouchGeometry;
+
+	/** Sampled easing for each crouch transition */
+	mutable FPBCrouchCurve CrouchCurves[(int32)EPBCrouchTransition::Count];
+
+	/** Prebuilt parameters for each PB query */
+	FPBQueryParams QueryParamsCache[(int32)EPBQueryParams::Count];
+
+	/** Crouch transition state, 0 standing to 1 fully crouched */
+	float CrouchAlpha = 0.0f;
+
+	/** Record where the capsule is now */
+	void RecordCapsuleHistory();
+
+	FPBCapsuleHistory CapsuleHistory;
+	bool bIsRecordingCapsuleHistory = false;
+
+	/** Timestamp of the move being performed, the same on server and client */
+	float GetMoveTimeStamp() const;
+
+	/** All of this pawn's movement randomness comes from here */
+	FPBRandomStream MoveRandomStream;
+
+	/** Step sound picks, kept apart so whether a sound is audible can't change the movement sequence */
+	FPBRandomStream CosmeticRandomStream;
+
+	/** Set while MoveAutonomous runs a client move, on the server or when the client replays it */
+	bool bInAutonomousMove = false;
+	float AutonomousMoveTimeStamp = 0.0f;
+
+	/** PB state that changed over the last client move on the server, reported if the move needs correcting */
+	EPBCorrectionCause PendingCorrectionCauses = EPBCorrectionCause::None;
+
+	/** If ShouldCatchAir launched us during the current move */
+	bool bCaughtAirThisMove = false;
+
+	/** Reachability tables we last looked up */
+	mutable TSharedPtr<const FPBJumpReachability> JumpReachability;
 };
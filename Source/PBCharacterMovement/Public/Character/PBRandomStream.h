@@ -0,0 +1,77 @@
+// Copyright Project Borealis
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Small seeded random stream (xoshiro128**) for per-pawn movement randomness.
+ * Each pawn owns one, so the same seed replays the same sequence and pawns ticking
+ * in parallel never share state. Never allocates.
+ */
+struct FPBRandomStream
+{
+	FPBRandomStream()
+	{
+		Initialize(0);
+	}
+
+	explicit FPBRandomStream(uint32 Seed)
+	{
+		Initialize(Seed);
+	}
+
+	/** Reset the stream to the start of a seed's sequence */
+	void Initialize(uint32 Seed)
+	{
+		// Expand the seed with splitmix64, which never gives the all zero state xoshiro can't leave
+		uint64 SplitMix = Seed;
+		for (int32 Index = 0; Index < 4; Index += 2)
+		{
+			SplitMix += 0x9E3779B97F4A7C15ull;
+			uint64 Mixed = SplitMix;
+			Mixed = (Mixed ^ (Mixed >> 30)) * 0xBF58476D1CE4E5B9ull;
+			Mixed = (Mixed ^ (Mixed >> 27)) * 0x94D049BB133111EBull;
+			Mixed ^= Mixed >> 31;
+			State[Index] = (uint32)Mixed;
+			State[Index + 1] = (uint32)(Mixed >> 32);
+		}
+	}
+
+	/** Random 32 bit value */
+	uint32 GetUnsigned()
+	{
+		const uint32 Result = Rotl(State[1] * 5, 7) * 9;
+		const uint32 Shifted = State[1] << 9;
+
+		State[2] ^= State[0];
+		State[3] ^= State[1];
+		State[1] ^= State[2];
+		State[0] ^= State[3];
+		State[2] ^= Shifted;
+		State[3] = Rotl(State[3], 11);
+
+		return Result;
+	}
+
+	/** Random float in [0, 1) */
+	float FRand()
+	{
+		return (GetUnsigned() >> 8) * (1.0f / 16777216.0f);
+	}
+
+	/** Random integer in [Min, Max] */
+	int32 RandRange(int32 Min, int32 Max)
+	{
+		const uint64 Range = (uint64)((int64)Max - (int64)Min + 1);
+		return Range > 1 ? Min + (int32)(((uint64)GetUnsigned() * Range) >> 32) : Min;
+	}
+
+private:
+	static uint32 Rotl(uint32 Value, int32 Shift)
+	{
+		return (Value << Shift) | (Value >> (32 - Shift));
+	}
+
+	uint32 State[4];
+};
@@ -0,0 +1,35 @@
+// Copyright Project Borealis
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "GameFramework/CharacterMovementComponent.h"
+
+/** Saved move that also remembers the PB state the move started in, so moves are only combined when it matches */
+class PBCHARACTERMOVEMENT_API FSavedMove_PB : public FSavedMove_Character
+{
+public:
+	typedef FSavedMove_Character Super;
+
+	bool bSprinting = false;
+	bool bWantsToWalk = false;
+	bool bInCrouchTransition = false;
+	bool bBrakingWindowElapsed = false;
+	bool bOnLadder = false;
+
+	virtual void Clear() override;
+	virtual void SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData) override;
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+	virtual void CombineWith(const FSavedMove_Character* OldMove, ACharacter* InCharacter, APlayerController* PC, const FVector& OldStartLocation) override;
+};
+
+class PBCHARACTERMOVEMENT_API FNetworkPredictionData_Client_PB : public FNetworkPredictionData_Client_Character
+{
+public:
+	typedef FNetworkPredictionData_Client_Character Super;
+
+	FNetworkPredictionData_Client_PB(const UCharacterMovementComponent& ClientMovement);
+
+	virtual FSavedMovePtr AllocateNewMove() override;
+};
@@ -20,23 +20,32 @@ public:
 	UFUNCTION()
 	TEnumAsByte<enum EPhysicalSurface> GetSurfaceMaterial() const { return SurfaceMaterial; }
 
-	UFUNCTION()
-	TArray<USoundCue*> GetStepLeftSounds() const { return StepLeftSounds; }
+	const TArray<TSoftObjectPtr<USoundCue>>& GetStepLeftSounds() const { return StepLeftSounds; }
 
-	UFUNCTION()
-	TArray<USoundCue*> GetStepRightSounds() const { return StepRightSounds; }
+	const TArray<TSoftObjectPtr<USoundCue>>& GetStepRightSounds() const { return StepRightSounds; }
 
-	UFUNCTION()
-	TArray<USoundCue*> GetSprintLeftSounds() const { return SprintLeftSounds; }
+	const TArray<TSoftObjectPtr<USoundCue>>& GetSprintLeftSounds() const { return SprintLeftSounds; }
 
-	UFUNCTION()
-	TArray<USoundCue*> GetSprintRightSounds() const { return SprintRightSounds; }
+	const TArray<TSoftObjectPtr<USoundCue>>& GetSprintRightSounds() const { return SprintRightSounds; }
 
-	UFUNCTION()
-	TArray<USoundCue*> GetJumpSounds() const { return JumpSounds; }
+	const TArray<TSoftObjectPtr<USoundCue>>& GetJumpSounds() const { return JumpSounds; }
 
-	UFUNCTION()
-	TArray<USoundCue*> GetLandSounds() const { return LandSounds; }
+	const TArray<TSoftObjectPtr<USoundCue>>& GetLandSounds() const { return LandSounds; }
+
+	/** Every sound in this set, for preloading */
+	void GetAllSounds(TArray<FSoftObjectPath>& OutSounds) const
+	{
+		for (const TArray<TSoftObjectPtr<USoundCue>>* Sounds : {&StepLeftSounds, &StepRightSounds, &SprintLeftSounds, &SprintRightSounds, &JumpSounds, &LandSounds})
+		{
+			for (const TSoftObjectPtr<USoundCue>& Sound : *Sounds)
+			{
+				if (!Sound.IsNull())
+				{
+					OutSounds.AddUnique(Sound.ToSoftObjectPath());
+				}
+			}
+		}
+	}
 
 	UFUNCTION()
 	float GetWalkVolume() const { return WalkVolume; }
@@ -51,27 +60,27 @@ private:
 
 	/** The list of sounds to randomly choose from when stepping left */
 	UPROPERTY(EditDefaultsOnly, Category = Sounds)
-	TArray<USoundCue*> StepLeftSounds;
+	TArray<TSoftObjectPtr<USoundCue>> StepLeftSounds;
 
 	/** The list of sounds to randomly choose from when stepping right */
 	UPROPERTY(EditDefaultsOnly, Category = Sounds)
-	TArray<USoundCue*> StepRightSounds;
+	TArray<TSoftObjectPtr<USoundCue>> StepRightSounds;
 
 	/** The list of sounds to randomly choose from when sprinting left */
 	UPROPERTY(EditDefaultsOnly, Category = Sounds)
-	TArray<USoundCue*> SprintLeftSounds;
+	TArray<TSoftObjectPtr<USoundCue>> SprintLeftSounds;
 
 	/** The list of sounds to randomly choose from when sprinting right */
 	UPROPERTY(EditDefaultsOnly, Category = Sounds)
-	TArray<USoundCue*> SprintRightSounds;
+	TArray<TSoftObjectPtr<USoundCue>> SprintRightSounds;
 
 	/** The list of sounds to randomly choose from when jumping */
 	UPROPERTY(EditDefaultsOnly, Category = Sounds)
-	TArray<USoundCue*> JumpSounds;
+	TArray<TSoftObjectPtr<USoundCue>> JumpSounds;
 
 	/** The list of sounds to randomly choose from when landing */
 	UPROPERTY(EditDefaultsOnly, Category = Sounds)
-	TArray<USoundCue*> LandSounds;
+	TArray<TSoftObjectPtr<USoundCue>> LandSounds;
 
 	UPROPERTY(EditDefaultsOnly, Category = Volume)
 	float WalkVolume = 0.2f;
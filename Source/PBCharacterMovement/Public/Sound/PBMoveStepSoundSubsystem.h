@@ -0,0 +1,85 @@
+// Copyright Project Borealis
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "Engine/EngineTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "PBMoveStepSoundSubsystem.generated.h"
+
+class ULevel;
+class USoundCue;
+class UWorld;
+class UPBMoveStepSound;
+struct FStreamableHandle;
+
+DECLARE_LOG_CATEGORY_EXTERN(LogPBMoveStepSound, Log, All);
+
+/**
+ * Streams in the move step sounds for only the physical surfaces used by the loaded levels.
+ * Surfaces the scan can't see (landscape layers, spawned actors) start loading on first use and stay silent until they are in.
+ */
+UCLASS()
+class PBCHARACTERMOVEMENT_API UPBMoveStepSoundSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	typedef TMap<TEnumAsByte<EPhysicalSurface>, TSoftClassPtr<UPBMoveStepSound>> FMoveStepSoundMap;
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** Register a pawn's step sound sets, and start loading those for surfaces in the world */
+	void PreloadMoveStepSounds(const FMoveStepSoundMap& MoveStepSounds);
+
+	/** Furthest any preloaded step sound can be heard from, or 0 if none are loaded yet */
+	float GetMaxAudibleDistance() const
+	{
+		return MaxAudibleDistance;
+	}
+
+	/** Get a step sound set if it's loaded, otherwise start loading it in the background and return null */
+	static UPBMoveStepSound* ResolveMoveStepSound(const UWorld* World, const TSoftClassPtr<UPBMoveStepSound>& MoveStepSound);
+
+	/** Get a sound cue if it's loaded, otherwise start loading it in the background and return null */
+	static USoundCue* ResolveSound(const UWorld* World, const TSoftObjectPtr<USoundCue>& Sound);
+
+private:
+	void OnLevelAdded(ULevel* Level, UWorld* World);
+	void ScanLevel(ULevel* Level);
+	void RequestLoads();
+	void LoadMoveStepSounds(TArray<FSoftObjectPath> ClassPaths);
+	void LoadMoveStepSoundOnUse(const FSoftObjectPath& ClassPath);
+	void LoadSoundOnUse(const FSoftObjectPath& SoundPath);
+	void OnMoveStepSoundsLoaded(TArray<FSoftObjectPath> ClassPaths, double StartTime);
+	void OnSoundsLoaded(TArray<FSoftObjectPath> SoundPaths, double StartTime);
+
+	/** Step sound sets registered by pawns, by surface */
+	TMap<uint8, TArray<TSoftClassPtr<UPBMoveStepSound>, TInlineAllocator<1>>> MoveStepSoundsBySurface;
+
+	/** Bit per surface type found in the scanned levels */
+	uint64 SurfacesInWorld = 0;
+
+	/** Step sound sets already requested */
+	TSet<FSoftObjectPath> RequestedMoveStepSounds;
+
+	/** Sound cues requested on first use, outside of a step sound set load */
+	TSet<FSoftObjectPath> RequestedSounds;
+
+	/** Keeps the preloaded assets resident for the lifetime of the world */
+	TArray<TSharedPtr<FStreamableHandle>> Handles;
+
+	/** Sounds already counted in ResidentBytes, a cue can finish loading through more than one handle */
+	TSet<FSoftObjectPath> CountedSounds;
+
+	/** Estimated size of the preloaded sounds */
+	int64 ResidentBytes = 0;
+
+	float MaxAudibleDistance = 0.0f;
+
+	FDelegateHandle LevelAddedHandle;
+};